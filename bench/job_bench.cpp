@@ -0,0 +1,188 @@
+// Measures the job system on its own and writes the results to JSON: the cost of an empty job
+// from submit to completion, how a parallel loop of fixed work scales with the thread count,
+// and how fast a chain of continuations hands work from one job to the next.
+//
+//     job_bench [--jobs N] [--out job_bench_results.json]
+#include "../tarask_job_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using tarask::TaraskJobCounter;
+    using tarask::TaraskJobSystem;
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // roughly a microsecond of arithmetic the optimizer cannot drop
+    float busyWork(uint32_t seed)
+    {
+        float value = static_cast<float>(seed);
+        for (int i = 0; i < 200; i++)
+        {
+            value = std::sqrt(value * 1.0001f + 1.0f);
+        }
+        return value;
+    }
+
+    struct Result
+    {
+        std::string name;
+        uint32_t threads = 0;
+        uint32_t items = 0;
+        double ms = 0.0;
+        // nanoseconds per job or per item
+        double nsPerItem = 0.0;
+        uint64_t steals = 0;
+    };
+
+    // submit and wait on jobs that do nothing, all from the calling thread
+    Result emptyJobs(uint32_t threads, uint32_t jobCount)
+    {
+        TaraskJobSystem jobs{threads};
+        TaraskJobCounter counter;
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < jobCount; i++)
+        {
+            jobs.run([](uint32_t) {}, &counter);
+        }
+        jobs.wait(counter);
+        double ms = elapsedMs(start);
+        return {"empty_jobs", jobs.threadCount(), jobCount, ms, ms * 1e6 / jobCount,
+                jobs.stealCount()};
+    }
+
+    // the same loop of busy work at every thread count, the speedup is the scaling
+    Result parallelLoop(uint32_t threads, uint32_t itemCount, uint32_t grainSize)
+    {
+        TaraskJobSystem jobs{threads};
+        std::vector<float> results(itemCount);
+        auto start = Clock::now();
+        jobs.parallelFor(
+            itemCount, [&](uint32_t i, uint32_t) { results[i] = busyWork(i); }, grainSize);
+        double ms = elapsedMs(start);
+        return {"parallel_for_grain_" + std::to_string(grainSize), jobs.threadCount(), itemCount,
+                ms, ms * 1e6 / itemCount, jobs.stealCount()};
+    }
+
+    // every job only becomes runnable once the one before it completed
+    Result continuationChain(uint32_t threads, uint32_t length)
+    {
+        TaraskJobSystem jobs{threads};
+        std::vector<std::unique_ptr<TaraskJobCounter>> links;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            links.push_back(std::make_unique<TaraskJobCounter>());
+        }
+        std::atomic<uint32_t> ran{0};
+        TaraskJobCounter done;
+
+        auto start = Clock::now();
+        jobs.run([&](uint32_t) { ran++; }, links[0].get());
+        for (uint32_t i = 1; i < length; i++)
+        {
+            jobs.runAfter(*links[i - 1], [&](uint32_t) { ran++; }, links[i].get());
+        }
+        jobs.runAfter(*links[length - 1], [](uint32_t) {}, &done);
+        jobs.wait(done);
+        double ms = elapsedMs(start);
+        if (ran.load() != length)
+        {
+            std::fprintf(stderr, "job_bench: continuation chain ran %u of %u jobs\n", ran.load(),
+                         length);
+            std::exit(EXIT_FAILURE);
+        }
+        // the counters are waited on one by one so none is destroyed under a finishing job
+        for (auto &link : links)
+        {
+            jobs.wait(*link);
+        }
+        return {"continuation_chain", jobs.threadCount(), length, ms, ms * 1e6 / length,
+                jobs.stealCount()};
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t jobCount = 100000;
+    const char *outPath = "job_bench_results.json";
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+        {
+            jobCount = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--jobs N] [--out file.json]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    uint32_t hardwareThreads = std::max(2u, std::thread::hardware_concurrency());
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threads = 2; threads < hardwareThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    std::vector<Result> results;
+    for (uint32_t threads : threadCounts)
+    {
+        results.push_back(emptyJobs(threads, jobCount));
+        results.push_back(parallelLoop(threads, jobCount, 1));
+        results.push_back(parallelLoop(threads, jobCount, 64));
+        results.push_back(continuationChain(threads, std::min(jobCount, 10000u)));
+    }
+
+    std::printf("%-24s %8s %10s %12s %12s %10s\n", "scenario", "threads", "items", "ms",
+                "ns/item", "steals");
+    for (const auto &result : results)
+    {
+        std::printf("%-24s %8u %10u %12.3f %12.1f %10llu\n", result.name.c_str(), result.threads,
+                    result.items, result.ms, result.nsPerItem,
+                    static_cast<unsigned long long>(result.steals));
+    }
+
+    std::FILE *out = std::fopen(outPath, "w");
+    if (out == nullptr)
+    {
+        std::fprintf(stderr, "job_bench: cannot write %s\n", outPath);
+        return EXIT_FAILURE;
+    }
+    std::fprintf(out, "{\n  \"hardware_threads\": %u,\n  \"scenarios\": [\n", hardwareThreads);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &result = results[i];
+        std::fprintf(out,
+                     "    {\"name\": \"%s\", \"threads\": %u, \"items\": %u, \"ms\": %.4f, "
+                     "\"ns_per_item\": %.2f, \"steals\": %llu}%s\n",
+                     result.name.c_str(), result.threads, result.items, result.ms,
+                     result.nsPerItem, static_cast<unsigned long long>(result.steals),
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    std::fclose(out);
+    std::printf("wrote %s\n", outPath);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+// Runs fixed scenarios through FirstApp in headless mode and writes the timings to JSON:
+// Sierpinski triangles at several depths, growing instance counts, one and three frames in
+// flight and a resize storm.
+//
+//     scene_bench [--frames N] [--out bench_results.json]
+#include "../first_app.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using tarask::AppConfig;
+    using tarask::RunStats;
+
+    struct Scenario
+    {
+        std::string name;
+        AppConfig config;
+    };
+
+    struct Summary
+    {
+        double min = 0.0;
+        double avg = 0.0;
+        double p50 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    Summary summarize(std::vector<double> samples)
+    {
+        Summary summary{};
+        if (samples.empty())
+        {
+            return summary;
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double sample : samples)
+        {
+            total += sample;
+        }
+        summary.min = samples.front();
+        summary.avg = total / samples.size();
+        summary.p50 = samples[samples.size() / 2];
+        summary.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+        summary.max = samples.back();
+        return summary;
+    }
+
+    void writeSummary(std::FILE *out, const char *name, const std::vector<double> &samples,
+                      bool last)
+    {
+        Summary s = summarize(samples);
+        std::fprintf(out,
+                     "      \"%s\": {\"samples\": %zu, \"min\": %.4f, \"avg\": %.4f, "
+                     "\"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+                     name, samples.size(), s.min, s.avg, s.p50, s.p99, s.max, last ? "" : ",");
+    }
+
+    std::vector<Scenario> makeScenarios(uint32_t frameCount)
+    {
+        AppConfig base{};
+        base.headless = true;
+        base.frameCount = frameCount;
+
+        std::vector<Scenario> scenarios;
+        for (uint32_t depth : {4u, 7u, 10u})
+        {
+            AppConfig config = base;
+            config.sierpinskiDepth = depth;
+            scenarios.push_back({"sierpinski_depth_" + std::to_string(depth), config});
+        }
+        for (uint32_t count : {4u, 1024u, 16384u, 262144u})
+        {
+            AppConfig config = base;
+            config.instanceCount = count;
+            scenarios.push_back({"instances_" + std::to_string(count), config});
+        }
+        for (uint32_t framesInFlight : {1u, 3u})
+        {
+            AppConfig config = base;
+            config.sierpinskiDepth = 7;
+            config.renderTarget.framesInFlight = framesInFlight;
+            scenarios.push_back({"frames_in_flight_" + std::to_string(framesInFlight), config});
+        }
+        AppConfig resize = base;
+        resize.resizeEvery = 10;
+        scenarios.push_back({"resize_storm", resize});
+        return scenarios;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t frameCount = 500;
+    const char *outPath = "bench_results.json";
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--frames N] [--out file.json]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Scenario> scenarios = makeScenarios(frameCount);
+    std::vector<RunStats> results;
+    try
+    {
+        for (const auto &scenario : scenarios)
+        {
+            std::printf("%s\n", scenario.name.c_str());
+            tarask::FirstApp app{scenario.config};
+            app.run();
+            results.push_back(app.stats());
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    std::FILE *out = std::fopen(outPath, "w");
+    if (out == nullptr)
+    {
+        std::fprintf(stderr, "scene_bench: cannot write %s\n", outPath);
+        return EXIT_FAILURE;
+    }
+    std::fprintf(out, "{\n  \"frames\": %u,\n  \"scenarios\": [\n", frameCount);
+    for (size_t i = 0; i < scenarios.size(); i++)
+    {
+        const AppConfig &config = scenarios[i].config;
+        const RunStats &stats = results[i];
+        std::fprintf(out, "    {\n      \"name\": \"%s\",\n", scenarios[i].name.c_str());
+        std::fprintf(out,
+                     "      \"width\": %u, \"height\": %u, \"sierpinski_depth\": %u, "
+                     "\"instances\": %u, \"resize_every\": %u,\n",
+                     config.width, config.height, config.sierpinskiDepth, config.instanceCount,
+                     config.resizeEvery);
+        std::fprintf(out, "      \"seconds\": %.4f, \"fps\": %.2f,\n", stats.seconds,
+                     stats.seconds > 0.0 ? stats.frames / stats.seconds : 0.0);
+        writeSummary(out, "record_ms", stats.recordMs, false);
+        writeSummary(out, "submit_present_ms", stats.submitMs, false);
+        writeSummary(out, "gpu_ms", stats.gpuMs, false);
+        std::fprintf(out, "      \"gpu_scopes\": {");
+        for (size_t j = 0; j < stats.gpuScopes.size(); j++)
+        {
+            const auto &scope = stats.gpuScopes[j];
+            std::fprintf(out, "%s\"%s\": {\"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f}",
+                         j == 0 ? "" : ", ", scope.name.c_str(), scope.minMs, scope.avgMs,
+                         scope.p99Ms);
+        }
+        std::fprintf(out, "}\n");
+        std::fprintf(out, "    }%s\n", i + 1 < scenarios.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    std::fclose(out);
+    std::printf("wrote %s\n", outPath);
+    return EXIT_SUCCESS;
+}
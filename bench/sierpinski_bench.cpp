@@ -0,0 +1,117 @@
+// Times Sierpinski generation for depths 6 to 14: the original recursive push_back version,
+// the preallocated scalar path, the SIMD path on one thread, the default (scalar) path on every
+// thread and the default path run as jobs.
+#include "../tarask_job_system.hpp"
+#include "../tarask_sierpinski.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using tarask::TaraskModel;
+    using tarask::TaraskSierpinski;
+
+    const glm::vec2 LEFT{-0.9f, 0.9f};
+    const glm::vec2 RIGHT{0.9f, 0.9f};
+    const glm::vec2 TOP{0.0f, -0.9f};
+
+    // verbatim copy of the old FirstApp::sierpinski
+    void recursivePushBack(std::vector<TaraskModel::Vertex> &vertices, int depth, glm::vec2 left,
+                           glm::vec2 right, glm::vec2 top)
+    {
+        if (depth <= 0)
+        {
+            vertices.push_back({top, {1.0f, 0.0f, 0.0f}});
+            vertices.push_back({right, {0.0f, 1.0f, 0.0f}});
+            vertices.push_back({left, {0.0f, 0.0f, 1.0f}});
+        }
+        else
+        {
+            auto leftTop = 0.5f * (left + top);
+            auto rightTop = 0.5f * (right + top);
+            auto leftRight = 0.5f * (left + right);
+            recursivePushBack(vertices, depth - 1, left, leftRight, leftTop);
+            recursivePushBack(vertices, depth - 1, leftRight, right, rightTop);
+            recursivePushBack(vertices, depth - 1, leftTop, rightTop, top);
+        }
+    }
+
+    // best of a few runs, in milliseconds
+    double timeMs(const std::function<void()> &run, int repeats)
+    {
+        double best = 1e30;
+        for (int i = 0; i < repeats; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    bool sameVertices(const std::vector<TaraskModel::Vertex> &a,
+                      const std::vector<TaraskModel::Vertex> &b)
+    {
+        return a.size() == b.size() &&
+               std::memcmp(a.data(), b.data(), a.size() * sizeof(TaraskModel::Vertex)) == 0;
+    }
+} // namespace
+
+int main()
+{
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    tarask::TaraskJobSystem jobSystem;
+    std::printf("%5s %12s %14s %14s %14s %14s %14s %8s\n", "depth", "vertices", "push_back ms",
+                "scalar ms", "simd ms", "parallel ms", "jobs ms", "match");
+    for (int depth = 6; depth <= 14; depth++)
+    {
+        int repeats = depth <= 10 ? 5 : 1;
+        size_t count = TaraskSierpinski::vertexCount(depth);
+
+        std::vector<TaraskModel::Vertex> reference;
+        double pushBackMs = timeMs(
+            [&] {
+                reference.clear();
+                reference.shrink_to_fit();
+                recursivePushBack(reference, depth, LEFT, RIGHT, TOP);
+            },
+            repeats);
+
+        std::vector<TaraskModel::Vertex> scalar(count);
+        double scalarMs = timeMs(
+            [&] { TaraskSierpinski::generateScalar(scalar.data(), depth, LEFT, RIGHT, TOP); },
+            repeats);
+
+        std::vector<TaraskModel::Vertex> simd(count);
+        double simdMs = timeMs(
+            [&] { TaraskSierpinski::generateSimd(simd.data(), depth, LEFT, RIGHT, TOP); },
+            repeats);
+
+        std::vector<TaraskModel::Vertex> parallel(count);
+        double parallelMs = timeMs(
+            [&] { TaraskSierpinski::generate(parallel.data(), depth, LEFT, RIGHT, TOP); },
+            repeats);
+
+        std::vector<TaraskModel::Vertex> jobs(count);
+        double jobsMs = timeMs(
+            [&] { TaraskSierpinski::generate(jobs.data(), depth, LEFT, RIGHT, TOP, jobSystem); },
+            repeats);
+
+        bool match = sameVertices(reference, scalar) && sameVertices(reference, simd) &&
+                     sameVertices(reference, parallel) && sameVertices(reference, jobs);
+        std::printf("%5d %12zu %14.3f %14.3f %14.3f %14.3f %14.3f %8s\n", depth, count,
+                    pushBackMs, scalarMs, simdMs, parallelMs, jobsMs, match ? "yes" : "NO");
+        if (!match)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
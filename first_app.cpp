@@ -1,23 +1,52 @@
 #include "first_app.hpp"
 
+#include "tarask_trace.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
 #include <array>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <exception>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 
 namespace tarask
 {
-    struct SimplePushConstantData
+    // matches FrameData in simple_instanced.vert
+    struct FrameUniforms
+    {
+        glm::vec2 viewScale;
+        glm::vec2 viewOffset;
+    };
+
+    // matches Push in simple_bindless.vert, the frame uniforms plus where the objects are
+    struct BindlessPushConstants
     {
-        glm::vec2 offset;
-        alignas(16) glm::vec3 color;
+        glm::vec2 viewScale;
+        glm::vec2 viewOffset;
+        uint32_t objectBuffer;
     };
 
-    FirstApp::FirstApp()
+    namespace
+    {
+        // GLFW event calls are only allowed off the render thread
+        thread_local bool t_renderThread = false;
+    } // namespace
+
+    FirstApp::FirstApp(const AppConfig &config)
+        : m_config{config},
+          m_taraskWindow{config.headless ? nullptr
+                                         : std::make_unique<TaraskWindow>(
+                                               config.width, config.height,
+                                               "Tarask Vulkan Engine")},
+          m_taraskDevice{m_taraskWindow.get()}
     {
         loadModels();
         createPipelineLayout();
@@ -26,37 +55,152 @@ namespace tarask
     }
     FirstApp::~FirstApp()
     {
-        vkDestroyPipelineLayout(m_taraskDevice.device(), m_pipelineLayout, nullptr);
+        m_pipelineManager.waitIdle();
+        m_taraskDevice.deletionQueue().destroyPipelineLayout(m_pipelineLayout);
     }
     void FirstApp::run()
     {
-        while (!m_taraskWindow.shouldClose())
+        m_stats = RunStats{};
+        m_stats.recordMs.reserve(m_config.frameCount);
+        m_stats.submitMs.reserve(m_config.frameCount);
+        m_stats.gpuMs.reserve(m_config.frameCount);
+        m_stats.inputLatencyMs.reserve(m_config.frameCount);
+        const AppConfig initial = m_config;
+        m_frameLimiter.setMaxFps(m_config.maxFps);
+        m_stopRendering = false;
+        m_renderingDone = false;
+
+        auto start = std::chrono::steady_clock::now();
+        uint32_t frames = 0;
+        if (!m_taraskWindow)
         {
-            glfwPollEvents();
-            drawFrame();
+            frames = renderFrames();
         }
+        else
+        {
+            // a blocking acquire no longer holds up the events, nor a slow callback the frame
+            std::exception_ptr renderError;
+            m_renderThread = std::thread(
+                [&]
+                {
+                    TARASK_TRACE_THREAD("render");
+                    t_renderThread = true;
+                    try
+                    {
+                        frames = renderFrames();
+                    }
+                    catch (...)
+                    {
+                        renderError = std::current_exception();
+                    }
+                    m_renderingDone = true;
+                    // wakes the main thread out of glfwWaitEvents
+                    glfwPostEmptyEvent();
+                });
 
-        vkDeviceWaitIdle(m_taraskDevice.device());
-    }
+            bool unsent = false;
+            FramePacket packet{};
+            while (!m_taraskWindow->shouldClose() && !m_renderingDone.load())
+            {
+                {
+                    TARASK_TRACE_SCOPE("glfwWaitEvents");
+                    if (unsent)
+                    {
+                        // come back soon to hand over what the full queue turned away
+                        glfwWaitEventsTimeout(0.001);
+                    }
+                    else
+                    {
+                        glfwWaitEvents();
+                    }
+                }
+                packet.polled = std::chrono::steady_clock::now();
+                unsent = !m_framePackets.tryPush(packet);
+            }
+            m_stopRendering = true;
+            m_renderThread.join();
+            if (renderError)
+            {
+                std::rethrow_exception(renderError);
+            }
+        }
 
-    void FirstApp::sierpinski(std::vector<TaraskModel::Vertex> &vertices, int depth, glm::vec2 left,
-                              glm::vec2 right, glm::vec2 top)
-    {
-        if (depth <= 0)
+        // the last frames have to finish before their timings can be read, nothing else
+        // needs the device idle
+        m_taraskDevice.graphicsTimeline().wait(m_taraskDevice.graphicsTimeline().submittedValue());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        m_stats.frames = frames;
+        m_stats.seconds = elapsed.count();
+        if (m_config.frameCount != 0)
         {
-            vertices.push_back({top, {1.0f, 0.0f, 0.0f}});
-            vertices.push_back({right, {0.0f, 1.0f, 0.0f}});
-            vertices.push_back({left, {0.0f, 0.0f, 1.0f}});
+            // pick up the timestamps of the last frames, the device is idle now
+            for (size_t i = 0; i < m_commandBuffers.size(); i++)
+            {
+                collectGpuTimes(static_cast<int>(i));
+            }
         }
-        else
+        if (m_gpuProfiler)
         {
-            auto leftTop = 0.5f * (left + top);
-            auto rightTop = 0.5f * (right + top);
-            auto leftRight = 0.5f * (left + right);
-            sierpinski(vertices, depth - 1, left, leftRight, leftTop);
-            sierpinski(vertices, depth - 1, leftRight, right, rightTop);
-            sierpinski(vertices, depth - 1, leftTop, rightTop, top);
+            m_stats.gpuScopes = m_gpuProfiler->stats();
+            for (const auto &scope : m_stats.gpuScopes)
+            {
+                std::cout << "FirstApp: gpu " << scope.name << " min " << scope.minMs << " avg "
+                          << scope.avgMs << " p99 " << scope.p99Ms << " ms" << std::endl;
+            }
+            if (m_gpuProfiler->hasPipelineStatistics())
+            {
+                std::cout << "FirstApp: last frame ran " << m_gpuProfiler->vertexInvocations()
+                          << " vertex and " << m_gpuProfiler->fragmentInvocations()
+                          << " fragment invocations" << std::endl;
+            }
+        }
+        m_config.width = initial.width;
+        m_config.height = initial.height;
+        std::cout << "FirstApp: scene commands recorded " << m_sceneCommands->recordCount()
+                  << " times" << std::endl;
+        std::cout << "FirstApp: " << frames << " frames in " << elapsed.count() << " s ("
+                  << frames / elapsed.count() << " fps)" << std::endl;
+    }
+
+    uint32_t FirstApp::renderFrames()
+    {
+        const AppConfig initial = m_config;
+        uint32_t frames = 0;
+        while ((m_config.frameCount == 0 || frames < m_config.frameCount) &&
+               !m_stopRendering.load())
+        {
+            bool freshInput = false;
+            FramePacket input{};
+            if (m_taraskWindow)
+            {
+                // only the newest input matters, older packets are already stale
+                FramePacket packet;
+                while (m_framePackets.tryPop(packet))
+                {
+                    input = packet;
+                    freshInput = true;
+                }
+            }
+            else if (m_config.resizeEvery != 0 && frames != 0 && frames % m_config.resizeEvery == 0)
+            {
+                // alternate between the configured extent and three quarters of it
+                bool shrink = m_config.width == initial.width;
+                m_config.width = shrink ? initial.width * 3 / 4 : initial.width;
+                m_config.height = shrink ? initial.height * 3 / 4 : initial.height;
+                recreateSwapChain();
+            }
+            drawFrame();
+            frames++;
+            if (freshInput && m_config.frameCount != 0)
+            {
+                m_stats.inputLatencyMs.push_back(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                              input.polled)
+                        .count());
+            }
+            m_frameLimiter.wait();
         }
+        return frames;
     }
 
     void FirstApp::loadModels()
@@ -66,28 +210,87 @@ namespace tarask
             {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}},
             {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
         };
-        // std::cout << "Starting calculating sierpinski triangle..." << std::endl;
-        // std::vector<TaraskModel::Vertex> vertices = {};
-        // sierpinski(vertices, 8, {-0.9f, 0.9f}, {0.9f, 0.9f}, {0.0f, -0.9f});
-        // std::cout << "Finished calculating sierpinski triangle..." << std::endl;
+        std::vector<uint32_t> indices{0, 1, 2};
+        if (m_config.sierpinskiDepth > 0)
+        {
+            // one vertex per distinct corner, neighbouring triangles share them
+            TaraskSierpinski::generateIndexed(static_cast<int>(m_config.sierpinskiDepth),
+                                              {-0.5f, 0.5f}, {0.5f, 0.5f}, {0.0f, -0.5f},
+                                              vertices, indices, m_jobSystem);
+        }
 
-        m_taraskModel = std::make_unique<TaraskModel>(m_taraskDevice, vertices);
+        // deep Sierpinski triangles outgrow the default arena
+        m_geometryArena = std::make_unique<TaraskGeometryArena>(
+            m_taraskDevice,
+            std::max(TaraskGeometryArena::DEFAULT_VERTEX_CAPACITY,
+                     static_cast<uint32_t>(vertices.size())),
+            std::max(TaraskGeometryArena::DEFAULT_INDEX_CAPACITY,
+                     static_cast<uint32_t>(indices.size())));
+        m_triangleMesh = m_geometryArena->addMesh(vertices, indices);
+
+        // columns of four copies, squeezed into the same width as the instance count grows,
+        // all scrolling right
+        uint32_t triangle = m_scene.addMesh(m_triangleMesh);
+        const uint32_t columns = (m_config.instanceCount + 3) / 4;
+        m_scene.reserve(m_config.instanceCount);
+        for (uint32_t j = 0; j < m_config.instanceCount; j++)
+        {
+            uint32_t row = j % 4;
+            float column = static_cast<float>(j / 4) / columns;
+            m_scene.create(triangle, {-0.5f + column, -0.4f + row * 0.25f}, {0.02f, 0.0f},
+                           {0.0f, column, 0.2f + 0.2f * row});
+        }
+        if (m_config.headless)
+        {
+            m_geometryArena->wait();
+        }
     }
 
     void FirstApp::createPipelineLayout()
     {
+        if (m_config.bindless)
+        {
+            if (TaraskBindlessTable::isSupported(m_taraskDevice))
+            {
+                m_bindlessTable = std::make_unique<TaraskBindlessTable>(
+                    m_taraskDevice, BINDLESS_STORAGE_BUFFERS, BINDLESS_SAMPLED_IMAGES);
+            }
+            else
+            {
+                std::cout << "FirstApp: no descriptor indexing, using dynamic offsets instead "
+                             "of the bindless table"
+                          << std::endl;
+            }
+        }
 
+        VkDescriptorSetLayout setLayout;
         VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
+        if (m_bindlessTable)
+        {
+            setLayout = m_bindlessTable->getDescriptorSetLayout();
+            pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+            pushConstantRange.offset = 0;
+            pushConstantRange.size = sizeof(BindlessPushConstants);
+        }
+        else
+        {
+            // per frame data comes from the ring, so offsets change without touching the set
+            m_frameSetLayout =
+                TaraskDescriptorSetLayout::Builder(m_taraskDevice)
+                    .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                                VK_SHADER_STAGE_VERTEX_BIT)
+                    .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+                                VK_SHADER_STAGE_VERTEX_BIT)
+                    .build();
+            setLayout = m_frameSetLayout->getDescriptorSetLayout();
+        }
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 0;
-        pipelineLayoutInfo.pSetLayouts = nullptr;
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = m_bindlessTable ? 1 : 0;
+        pipelineLayoutInfo.pPushConstantRanges = m_bindlessTable ? &pushConstantRange : nullptr;
         if (vkCreatePipelineLayout(m_taraskDevice.device(), &pipelineLayoutInfo, nullptr,
                                    &m_pipelineLayout) != VK_SUCCESS)
         {
@@ -97,49 +300,100 @@ namespace tarask
 
     void FirstApp::recreateSwapChain()
     {
-        auto extent = m_taraskWindow.getExtent();
-        while (extent.width == 0 || extent.height == 0)
-        {
-            extent = m_taraskWindow.getExtent();
-            glfwWaitEvents();
-        }
-        vkDeviceWaitIdle(m_taraskDevice.device());
-        if (m_taraskSwapChain == nullptr)
+        VkExtent2D extent{m_config.width, m_config.height};
+        if (m_taraskWindow)
         {
-            m_taraskSwapChain = std::make_unique<TaraskSwapChain>(m_taraskDevice, extent);
+            extent = m_taraskWindow->getExtent();
+            while (extent.width == 0 || extent.height == 0)
+            {
+                // minimized, only the main thread may wait on events
+                if (t_renderThread)
+                {
+                    if (m_stopRendering.load())
+                    {
+                        return;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                else
+                {
+                    glfwWaitEvents();
+                }
+                extent = m_taraskWindow->getExtent();
+            }
         }
-        else
+
+        if (m_renderTarget == nullptr)
         {
-            m_taraskSwapChain = std::make_unique<TaraskSwapChain>(m_taraskDevice, extent, std::move(m_taraskSwapChain));
-            if (m_taraskSwapChain->imageCount() != m_commandBuffers.size())
+            if (m_taraskWindow)
             {
-                freeCommandBuffers();
-                createCommandBuffers();
+                m_renderTarget = std::make_unique<TaraskSwapChain>(m_taraskDevice, extent,
+                                                                   m_config.renderTarget);
             }
+            else
+            {
+                m_renderTarget = std::make_unique<TaraskOffscreenTarget>(m_taraskDevice, extent,
+                                                                         m_config.renderTarget);
+            }
+            createPipeline();
+            return;
         }
 
-        createPipeline();
+        // frames in flight keep rendering into the old images while the new ones are built
+        VkRenderPass previousRenderPass = m_renderTarget->getRenderPass();
+        m_renderTarget->recreate(extent);
+        if (m_renderTarget->imageCount() != m_commandBuffers.size())
+        {
+            // the surface asked for another image count, the old per image resources retire
+            // through the deletion queue
+            freeCommandBuffers();
+            createCommandBuffers();
+        }
+        // the cached scene commands bake the extent and the render pass
+        if (m_sceneCommands)
+        {
+            m_sceneCommands->markDirty();
+        }
+        if (m_renderTarget->getRenderPass() != previousRenderPass)
+        {
+            // a background build may still reference the retired render pass
+            m_pipelineManager.waitIdle();
+            createPipeline();
+        }
     }
 
     void FirstApp::createPipeline()
     {
 
-        assert(m_taraskSwapChain != nullptr && "Cannot create pipeline before swap chain");
+        assert(m_renderTarget != nullptr && "Cannot create pipeline before swap chain");
         assert(m_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
         PipelineConfigInfo pipelineConfig{};
         TaraskPipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.renderPass = m_taraskSwapChain->getRenderPass();
+        pipelineConfig.renderPass = m_renderTarget->getRenderPass();
         pipelineConfig.pipelineLayout = m_pipelineLayout;
-        m_taraskPipeline = std::make_unique<TaraskPipeline>(
-            m_taraskDevice,
-            "shaders/simple_shader.vert.spv",
-            "shaders/simple_shader.frag.spv",
-            pipelineConfig);
+
+        // a pipeline built against an earlier, compatible render pass stays valid, so resizes
+        // just find the existing one. New pipelines compile in the background and frames
+        // are drawn without them until they are ready.
+        RenderPassCompatibility compatibility{};
+        compatibility.colorFormat = m_renderTarget->getSwapChainImageFormat();
+        compatibility.depthFormat = m_renderTarget->getSwapChainDepthFormat();
+        m_pipelineHandle = m_pipelineManager.getPipelineAsync(
+            m_bindlessTable ? "shaders/simple_bindless.vert.spv"
+                            : "shaders/simple_instanced.vert.spv",
+            "shaders/simple_instanced.frag.spv",
+            pipelineConfig,
+            compatibility);
+        if (!m_taraskWindow)
+        {
+            // headless runs are measured, don't let the first frames go out empty
+            m_pipelineHandle.wait();
+        }
 
         // auto pipelineConfig = TaraskPipeline::defaultPipelineConfigInfo(
-        //     m_taraskSwapChain->width(), m_taraskSwapChain->height());
-        // pipelineConfig.renderPass = m_taraskSwapChain->getRenderPass();
+        //     m_renderTarget->width(), m_renderTarget->height());
+        // pipelineConfig.renderPass = m_renderTarget->getRenderPass();
         // pipelineConfig.pipelineLayout = m_pipelineLayout;
         // m_taraskPipeline =
         //     std::make_unique<TaraskPipeline>(m_taraskDevice, "shaders/simple_shader.vert.spv",
@@ -148,7 +402,7 @@ namespace tarask
 
     void FirstApp::createCommandBuffers()
     {
-        m_commandBuffers.resize(m_taraskSwapChain->imageCount());
+        m_commandBuffers.resize(m_renderTarget->imageCount());
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -159,18 +413,123 @@ namespace tarask
         {
             throw std::runtime_error("FirstApp: failed to allocate command buffers.");
         }
+
+        // the frame uniforms and one entry per scene object, for every slot
+        uint32_t objectCapacity = std::max(1u, m_config.instanceCount);
+        VkDeviceSize objectBytes = sizeof(TaraskObjectData) * VkDeviceSize{objectCapacity};
+        VkDeviceSize alignment = std::max<VkDeviceSize>(
+            {m_taraskDevice.properties.limits.minUniformBufferOffsetAlignment,
+             m_taraskDevice.properties.limits.minStorageBufferOffsetAlignment, 1});
+        m_frameRing = std::make_unique<TaraskFrameRing>(
+            m_taraskDevice,
+            TaraskFrameRing::frameSize(sizeof(FrameUniforms) + objectBytes, 2, alignment),
+            static_cast<uint32_t>(m_commandBuffers.size()),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        m_frameOffsets.assign(m_commandBuffers.size(), {UINT32_MAX, UINT32_MAX});
+
+        if (m_bindlessTable)
+        {
+            // registered by drawFrame once the slot's objects have a place in the ring
+            m_objectBufferIndices.assign(m_commandBuffers.size(),
+                                         TaraskBindlessTable::INVALID_INDEX);
+        }
+        else
+        {
+            // one set for every frame, the dynamic offsets pick the slot's region
+            m_descriptorPool = TaraskDescriptorPool::Builder(m_taraskDevice)
+                                   .setMaxSets(1)
+                                   .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+                                   .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1)
+                                   .build();
+            VkDescriptorBufferInfo frameInfo{m_frameRing->buffer(), 0, sizeof(FrameUniforms)};
+            VkDescriptorBufferInfo objectInfo{m_frameRing->buffer(), 0, objectBytes};
+            if (!TaraskDescriptorWriter(*m_frameSetLayout, *m_descriptorPool)
+                     .writeBuffer(0, &frameInfo)
+                     .writeBuffer(1, &objectInfo)
+                     .build(m_frameSet))
+            {
+                throw std::runtime_error("FirstApp: failed to allocate the frame descriptor set.");
+            }
+        }
+
+        m_drawLists.resize(m_commandBuffers.size());
+        for (auto &drawList : m_drawLists)
+        {
+            drawList = std::make_unique<TaraskDrawList>(m_taraskDevice, MAX_DRAWS);
+        }
+        if (TaraskCullingPass::isSupported(m_taraskDevice))
+        {
+            m_cullingPass = std::make_unique<TaraskCullingPass>(
+                m_taraskDevice, std::max(MAX_DRAWS, m_config.instanceCount),
+                static_cast<uint32_t>(m_commandBuffers.size()));
+        }
+
+        m_sceneCommands = std::make_unique<TaraskCommandCache>(
+            m_taraskDevice, m_jobSystem, static_cast<uint32_t>(m_commandBuffers.size()));
+
+        if (TaraskGpuProfiler::isSupported(m_taraskDevice))
+        {
+            m_gpuProfiler = std::make_unique<TaraskGpuProfiler>(
+                m_taraskDevice, static_cast<uint32_t>(m_commandBuffers.size()), true);
+        }
     }
 
     void FirstApp::freeCommandBuffers()
     {
-        vkFreeCommandBuffers(m_taraskDevice.device(), m_taraskDevice.getCommandPool(),
-                             static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+        // pending frames may still execute them, the rest release themselves the same way
+        VkDevice device = m_taraskDevice.device();
+        VkCommandPool commandPool = m_taraskDevice.getCommandPool();
+        m_taraskDevice.deletionQueue().enqueue(
+            [device, commandPool, commandBuffers = std::move(m_commandBuffers)]()
+            {
+                vkFreeCommandBuffers(device, commandPool,
+                                     static_cast<uint32_t>(commandBuffers.size()),
+                                     commandBuffers.data());
+            });
         m_commandBuffers.clear();
+        m_sceneCommands.reset();
+        m_frameRing.reset();
+        m_descriptorPool.reset();
+        m_frameSet = VK_NULL_HANDLE;
+        m_frameOffsets.clear();
+        for (uint32_t index : m_objectBufferIndices)
+        {
+            if (index != TaraskBindlessTable::INVALID_INDEX)
+            {
+                m_bindlessTable->releaseStorageBuffer(index);
+            }
+        }
+        m_objectBufferIndices.clear();
+        m_drawLists.clear();
+        m_cullingPass.reset();
+        m_gpuProfiler.reset();
+    }
+
+    void FirstApp::collectGpuTimes(int imageIndex)
+    {
+        if (!m_gpuProfiler)
+        {
+            return;
+        }
+        m_gpuProfiler->collect(imageIndex);
+        if (m_config.frameCount == 0)
+        {
+            return;
+        }
+        for (const auto &timing : m_gpuProfiler->lastFrame())
+        {
+            if (*timing.name == "frame")
+            {
+                m_stats.gpuMs.push_back(timing.ms);
+            }
+        }
     }
     void FirstApp::recordCommandBuffer(int imageIndex)
     {
-        static int frame = 0;
-        frame = (frame + 1) % 100;
+        TARASK_TRACE_SCOPE("recordCommandBuffer");
+        m_animationFrame = (m_animationFrame + 1) % 100;
+        // the slot's previous frame, frames in flight ago
+        collectGpuTimes(imageIndex);
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -179,14 +538,124 @@ namespace tarask
         {
             throw std::runtime_error("FirstApp: failed to begin recording command buffer!");
         }
+        if (m_gpuProfiler)
+        {
+            m_gpuProfiler->beginFrame(m_commandBuffers[imageIndex], imageIndex);
+            m_gpuProfiler->beginScope(m_commandBuffers[imageIndex], "frame");
+        }
+
+        // meshes stream in on the transfer queue and pipelines compile on worker threads,
+        // skip the draws until both have landed
+        TaraskPipeline *pipeline = m_pipelineHandle.get();
+        bool drawScene = pipeline != nullptr && m_geometryArena->isReady();
+        if (drawScene)
+        {
+            const uint32_t objectCount = m_scene.objectCount();
+            // the slot's previous frame has completed, its region of the ring is free again
+            m_frameRing->beginFrame(imageIndex);
+            std::array<uint32_t, 2> offsets{};
+            if (!m_bindlessTable)
+            {
+                // the bindless path pushes these instead
+                FrameUniforms *frameUniforms = m_frameRing->allocate<FrameUniforms>(
+                    1, m_frameRing->uniformAlignment(), offsets[0]);
+                frameUniforms->viewScale = m_viewScale;
+                frameUniforms->viewOffset = m_viewOffset;
+            }
+            TaraskObjectData *objects = m_frameRing->allocate<TaraskObjectData>(
+                objectCount, m_frameRing->storageAlignment(), offsets[1]);
+            if (offsets != m_frameOffsets[imageIndex])
+            {
+                m_frameOffsets[imageIndex] = offsets;
+                if (m_bindlessTable)
+                {
+                    // only this slot reads its entry and its previous frame has completed,
+                    // so the entry can be rewritten in place
+                    VkDeviceSize objectBytes = sizeof(TaraskObjectData) *
+                                               VkDeviceSize{std::max(1u, m_config.instanceCount)};
+                    uint32_t &index = m_objectBufferIndices[imageIndex];
+                    if (index == TaraskBindlessTable::INVALID_INDEX)
+                    {
+                        index = m_bindlessTable->addStorageBuffer(m_frameRing->buffer(),
+                                                                  offsets[1], objectBytes);
+                    }
+                    else
+                    {
+                        m_bindlessTable->updateStorageBuffer(index, m_frameRing->buffer(),
+                                                             offsets[1], objectBytes);
+                    }
+                }
+                m_sceneCommands->markDirty(imageIndex);
+            }
+
+            uint32_t firstObject = 0;
+            if (m_cullingPass)
+            {
+                // one object per instance, so copies that left the screen are dropped
+                m_cullingPass->beginFrame(imageIndex);
+                m_cullingPass->setView(m_viewScale, m_viewOffset);
+                firstObject = m_cullingPass->addObjects(objectCount);
+            }
+            // each job streams its range straight from the component arrays into the mapped
+            // buffers while the range is still in cache
+            const float time = static_cast<float>(m_animationFrame);
+            m_jobSystem.parallelFor(
+                (objectCount + OBJECTS_PER_JOB - 1) / OBJECTS_PER_JOB,
+                [&](uint32_t job, uint32_t)
+                {
+                    uint32_t first = job * OBJECTS_PER_JOB;
+                    uint32_t count = std::min(OBJECTS_PER_JOB, objectCount - first);
+                    m_scene.animate(first, count, time);
+                    m_scene.writeObjects(objects, first, count);
+                    if (m_cullingPass)
+                    {
+                        for (uint32_t j = first; j < first + count; j++)
+                        {
+                            m_cullingPass->setObject(firstObject + j,
+                                                     m_scene.mesh(m_scene.meshIdAt(j)),
+                                                     m_scene.positionAt(j), j);
+                        }
+                    }
+                });
+
+            if (m_cullingPass)
+            {
+                if (m_gpuProfiler)
+                {
+                    m_gpuProfiler->beginScope(m_commandBuffers[imageIndex], "cull");
+                }
+                m_cullingPass->dispatch(m_commandBuffers[imageIndex],
+                                        m_renderTarget->getSwapChainExtent());
+                if (m_gpuProfiler)
+                {
+                    m_gpuProfiler->endScope(m_commandBuffers[imageIndex]);
+                }
+            }
+            else
+            {
+                // one draw per run of objects sharing a mesh
+                auto &drawList = *m_drawLists[imageIndex];
+                drawList.clear();
+                uint32_t runStart = 0;
+                for (uint32_t j = 1; j <= objectCount; j++)
+                {
+                    if (j == objectCount || m_scene.meshIdAt(j) != m_scene.meshIdAt(runStart))
+                    {
+                        drawList.addDraw(m_scene.mesh(m_scene.meshIdAt(runStart)),
+                                         j - runStart, runStart);
+                        runStart = j;
+                    }
+                }
+            }
+        }
 
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = m_taraskSwapChain->getRenderPass();
-        renderPassInfo.framebuffer = m_taraskSwapChain->getFrameBuffer(imageIndex);
+        renderPassInfo.renderPass = m_renderTarget->getRenderPass();
+        renderPassInfo.framebuffer = m_renderTarget->getFrameBuffer(imageIndex);
 
         renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = m_taraskSwapChain->getSwapChainExtent();
+        renderPassInfo.renderArea.extent = m_renderTarget->getSwapChainExtent();
 
         std::array<VkClearValue, 2> clearValues{};
         clearValues[0].color = {0.01f, 0.01f, 0.01f, 0.1f};
@@ -194,44 +663,119 @@ namespace tarask
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(m_commandBuffers[imageIndex], &renderPassInfo,
-                             VK_SUBPASS_CONTENTS_INLINE);
+        if (m_gpuProfiler)
+        {
+            m_gpuProfiler->beginStatistics(m_commandBuffers[imageIndex]);
+            m_gpuProfiler->beginScope(m_commandBuffers[imageIndex], "render_pass");
+        }
+        if (drawScene)
+        {
+            // Everything inside the render pass reads per slot buffers the CPU rewrites in
+            // place, so the recorded commands stay valid until the pipeline or the target
+            // changes. The instance count is fixed for the run, so are the draw counts.
+            if (pipeline != m_recordedPipeline)
+            {
+                m_sceneCommands->markDirty();
+                m_recordedPipeline = pipeline;
+            }
+            // large scenes are split across the workers, each chunk into its own secondary
+            uint32_t drawCount = m_cullingPass ? m_cullingPass->drawCount()
+                                               : m_drawLists[imageIndex]->drawCount();
+            uint32_t chunkCount = 1;
+            if (!m_cullingPass || m_cullingPass->canSplitDraws())
+            {
+                chunkCount = std::clamp((drawCount + DRAWS_PER_CHUNK - 1) / DRAWS_PER_CHUNK, 1u,
+                                        m_jobSystem.threadCount());
+            }
+            uint32_t drawsPerChunk = (drawCount + chunkCount - 1) / chunkCount;
+            const auto &sceneCommands = m_sceneCommands->get(
+                imageIndex, m_renderTarget->getRenderPass(),
+                m_gpuProfiler ? m_gpuProfiler->pipelineStatistics() : 0, chunkCount,
+                [this, pipeline, imageIndex, drawsPerChunk](VkCommandBuffer commandBuffer,
+                                                            uint32_t chunk)
+                {
+                    recordScene(commandBuffer, *pipeline, imageIndex, chunk * drawsPerChunk,
+                                drawsPerChunk);
+                });
+            vkCmdBeginRenderPass(m_commandBuffers[imageIndex], &renderPassInfo,
+                                 VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(m_commandBuffers[imageIndex],
+                                 static_cast<uint32_t>(sceneCommands.size()),
+                                 sceneCommands.data());
+        }
+        else
+        {
+            vkCmdBeginRenderPass(m_commandBuffers[imageIndex], &renderPassInfo,
+                                 VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        vkCmdEndRenderPass(m_commandBuffers[imageIndex]);
+        if (m_gpuProfiler)
+        {
+            m_gpuProfiler->endScope(m_commandBuffers[imageIndex]);
+            m_gpuProfiler->endStatistics(m_commandBuffers[imageIndex]);
+            m_gpuProfiler->endScope(m_commandBuffers[imageIndex]);
+        }
+        if (vkEndCommandBuffer(m_commandBuffers[imageIndex]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("FirstApp: failed to record command buffer.");
+        }
+    }
+    void FirstApp::recordScene(VkCommandBuffer commandBuffer, TaraskPipeline &pipeline,
+                               int imageIndex, uint32_t firstDraw, uint32_t drawCount)
+    {
+        // runs on the worker threads, it only reads state the render thread set up beforehand.
+        // Dynamic state and bindings are not inherited, every chunk sets its own.
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = static_cast<float>(m_taraskSwapChain->getSwapChainExtent().width);
-        viewport.height = static_cast<float>(m_taraskSwapChain->getSwapChainExtent().height);
+        viewport.width = static_cast<float>(m_renderTarget->getSwapChainExtent().width);
+        viewport.height = static_cast<float>(m_renderTarget->getSwapChainExtent().height);
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        VkRect2D scissor{{0, 0}, m_taraskSwapChain->getSwapChainExtent()};
-        vkCmdSetViewport(m_commandBuffers[imageIndex], 0, 1, &viewport);
-        vkCmdSetScissor(m_commandBuffers[imageIndex], 0, 1, &scissor);
-        m_taraskPipeline->bind(m_commandBuffers[imageIndex]);
-        m_taraskModel->bind(m_commandBuffers[imageIndex]);
+        VkRect2D scissor{{0, 0}, m_renderTarget->getSwapChainExtent()};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-        for (int j = 0; j < 4; j++)
+        pipeline.bind(commandBuffer);
+        m_geometryArena->bind(commandBuffer);
+        if (m_bindlessTable)
+        {
+            m_bindlessTable->bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  m_pipelineLayout, 0);
+            BindlessPushConstants push{};
+            push.viewScale = m_viewScale;
+            push.viewOffset = m_viewOffset;
+            push.objectBuffer = m_objectBufferIndices[imageIndex];
+            vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                               sizeof(push), &push);
+        }
+        else
         {
-            SimplePushConstantData push{};
-            push.offset = {-0.5f + frame * 0.02f, -0.4f + j * 0.25f};
-            push.color = {0.0f, 0.0f, 0.2f + 0.2f * j};
-            vkCmdPushConstants(m_commandBuffers[imageIndex],
-                               m_pipelineLayout,
-                               VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                               0,
-                               sizeof(SimplePushConstantData), &push);
-            m_taraskModel->draw(m_commandBuffers[imageIndex]);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                    m_pipelineLayout, 0, 1, &m_frameSet,
+                                    static_cast<uint32_t>(m_frameOffsets[imageIndex].size()),
+                                    m_frameOffsets[imageIndex].data());
         }
 
-        vkCmdEndRenderPass(m_commandBuffers[imageIndex]);
-        if (vkEndCommandBuffer(m_commandBuffers[imageIndex]) != VK_SUCCESS)
+        // every copy goes out through indirect draws
+        if (m_cullingPass)
         {
-            throw std::runtime_error("FirstApp: failed to record command buffer.");
+            m_cullingPass->draw(commandBuffer, firstDraw, drawCount);
+        }
+        else
+        {
+            m_drawLists[imageIndex]->record(commandBuffer, firstDraw, drawCount);
         }
     }
+
     void FirstApp::drawFrame()
     {
+        TARASK_TRACE_SCOPE("drawFrame");
+        // release whatever retired frames were the last to use
+        m_taraskDevice.deletionQueue().collect();
         uint32_t imageIndex;
-        auto result = m_taraskSwapChain->acquireNextImage(&imageIndex);
+        auto result = m_renderTarget->acquireNextImage(&imageIndex);
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
@@ -245,13 +789,23 @@ namespace tarask
         {
             throw std::runtime_error("FirstApp: failed to acquire swap chain image.");
         }
+        auto recordStart = std::chrono::steady_clock::now();
         recordCommandBuffer(imageIndex);
+        auto submitStart = std::chrono::steady_clock::now();
         result =
-            m_taraskSwapChain->submitCommandBuffers(&m_commandBuffers[imageIndex], &imageIndex);
-        if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR ||
-            m_taraskWindow.wasWindowResized())
+            m_renderTarget->submitCommandBuffers(&m_commandBuffers[imageIndex], &imageIndex);
+        if (m_config.frameCount != 0)
+        {
+            auto submitEnd = std::chrono::steady_clock::now();
+            m_stats.recordMs.push_back(
+                std::chrono::duration<double, std::milli>(submitStart - recordStart).count());
+            m_stats.submitMs.push_back(
+                std::chrono::duration<double, std::milli>(submitEnd - submitStart).count());
+        }
+        // written by the main thread, consumed here in one step
+        bool resized = m_taraskWindow && m_taraskWindow->consumeWindowResized();
+        if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR || resized)
         {
-            m_taraskWindow.resetWindowResizedFlag();
             recreateSwapChain();
             return;
         }
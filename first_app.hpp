@@ -1,34 +1,109 @@
 #pragma once
 
+#include "tarask_bindless.hpp"
+#include "tarask_command_cache.hpp"
+#include "tarask_culling_pass.hpp"
+#include "tarask_descriptors.hpp"
 #include "tarask_device.hpp"
+#include "tarask_draw_list.hpp"
+#include "tarask_frame_limiter.hpp"
+#include "tarask_frame_ring.hpp"
+#include "tarask_geometry_arena.hpp"
+#include "tarask_gpu_profiler.hpp"
+#include "tarask_job_system.hpp"
 #include "tarask_model.hpp"
+#include "tarask_offscreen_target.hpp"
 #include "tarask_pipeline.hpp"
+#include "tarask_pipeline_manager.hpp"
+#include "tarask_render_target.hpp"
+#include "tarask_scene.hpp"
+#include "tarask_sierpinski.hpp"
+#include "tarask_spsc_queue.hpp"
 #include "tarask_swap_chain.hpp"
 #include "tarask_window.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <vector>
 
 namespace tarask
 {
+    struct AppConfig
+    {
+        // render into offscreen images without creating a window or surface
+        bool headless = false;
+        // stop after this many frames, 0 runs until the window is closed
+        uint32_t frameCount = 0;
+        uint32_t width = 800;
+        uint32_t height = 600;
+        // 0 draws the single triangle, otherwise a Sierpinski triangle of that depth
+        uint32_t sierpinskiDepth = 0;
+        uint32_t instanceCount = 4;
+        // headless only, recreate the render target with another extent every N frames
+        uint32_t resizeEvery = 0;
+        // frames in flight, present mode and swap chain image count
+        RenderTargetSettings renderTarget{};
+        // cap on the frame rate, 0 leaves it to the present mode
+        double maxFps = 0.0;
+        // read the object data through a TaraskBindlessTable, ignored when the device lacks
+        // descriptor indexing
+        bool bindless = false;
+    };
+
+    // per frame timings of a run() with a fixed frame count, in milliseconds
+    struct RunStats
+    {
+        uint32_t frames = 0;
+        double seconds = 0.0;
+        std::vector<double> recordMs;
+        // submit plus present
+        std::vector<double> submitMs;
+        // whole command buffer from timestamp queries, only for frames whose results were
+        // ready when their slot came around again
+        std::vector<double> gpuMs;
+        // rolling statistics of every profiled scope at the end of the run
+        std::vector<TaraskGpuProfiler::ScopeStats> gpuScopes;
+        // windowed only, from the main thread polling input to the first frame submitted
+        // with it
+        std::vector<double> inputLatencyMs;
+    };
+
+    // what the main thread hands the render thread after each round of window events
+    struct FramePacket
+    {
+        std::chrono::steady_clock::time_point polled{};
+    };
+
     class FirstApp
     {
     public:
-        static constexpr int WIDTH = 800;
-        static constexpr int HEIGHT = 600;
+        static constexpr uint32_t MAX_DRAWS = 1024;
+        // below this many draws per worker, splitting the recording costs more than it saves
+        static constexpr uint32_t DRAWS_PER_CHUNK = 512;
+        // scene objects animated, written out and submitted for culling per job
+        static constexpr uint32_t OBJECTS_PER_JOB = 4096;
+        // bindless table size, the frames only use a storage buffer per slot so far
+        static constexpr uint32_t BINDLESS_STORAGE_BUFFERS = 1024;
+        static constexpr uint32_t BINDLESS_SAMPLED_IMAGES = 1024;
 
-        FirstApp();
+        FirstApp(const AppConfig &config = AppConfig{});
         ~FirstApp();
 
         FirstApp(const FirstApp &) = delete;
         FirstApp &operator=(const FirstApp &) = delete;
 
+        // Windowed, the calling thread only handles window events from here on and the
+        // frames are drawn and presented on a render thread. Headless, the caller draws.
         void run();
+        const RunStats &stats() const { return m_stats; }
 
     private:
+        // the frame loop, returns the number of frames drawn
+        uint32_t renderFrames();
         void loadModels();
-        void sierpinski(std::vector<TaraskModel::Vertex> &vertices, int depth, glm::vec2 left,
-                        glm::vec2 right, glm::vec2 top);
         void createPipelineLayout();
         void createPipeline();
         void createCommandBuffers();
@@ -36,13 +111,65 @@ namespace tarask
         void drawFrame();
         void recreateSwapChain();
         void recordCommandBuffer(int imageIndex);
+        // draws [firstDraw, firstDraw + drawCount) of the render pass contents, cached in
+        // m_sceneCommands
+        void recordScene(VkCommandBuffer commandBuffer, TaraskPipeline &pipeline, int imageIndex,
+                         uint32_t firstDraw, uint32_t drawCount);
+        void collectGpuTimes(int imageIndex);
 
-        TaraskWindow m_taraskWindow{WIDTH, HEIGHT, "Tarask Vulkan Engine"};
-        TaraskDevice m_taraskDevice{m_taraskWindow};
-        std::unique_ptr<TaraskSwapChain> m_taraskSwapChain;
-        std::unique_ptr<TaraskPipeline> m_taraskPipeline;
+        AppConfig m_config;
+        // null in headless mode
+        std::unique_ptr<TaraskWindow> m_taraskWindow;
+        TaraskDevice m_taraskDevice;
+        std::unique_ptr<TaraskRenderTarget> m_renderTarget;
+        // geometry generation, instance updates, scene recording and pipeline builds
+        TaraskJobSystem m_jobSystem;
+        TaraskPipelineManager m_pipelineManager{m_taraskDevice, m_jobSystem};
+        TaraskPipelineHandle m_pipelineHandle;
         VkPipelineLayout m_pipelineLayout;
         std::vector<VkCommandBuffer> m_commandBuffers;
-        std::unique_ptr<TaraskModel> m_taraskModel;
+        // secondary command buffers replayed by the primaries above, one per image
+        std::unique_ptr<TaraskCommandCache> m_sceneCommands;
+        // what m_sceneCommands were recorded with, a new pipeline marks them dirty
+        TaraskPipeline *m_recordedPipeline = nullptr;
+        // set 0 of the scene draws: the frame uniforms and the object array, both bound with
+        // dynamic offsets into m_frameRing
+        std::unique_ptr<TaraskDescriptorSetLayout> m_frameSetLayout;
+        std::unique_ptr<TaraskDescriptorPool> m_descriptorPool;
+        VkDescriptorSet m_frameSet = VK_NULL_HANDLE;
+        // a region per command buffer, rewritten whenever that command buffer is recorded
+        std::unique_ptr<TaraskFrameRing> m_frameRing;
+        // the dynamic offsets of each slot, baked into its cached scene commands
+        std::vector<std::array<uint32_t, 2>> m_frameOffsets;
+        // Replaces m_frameSetLayout as set 0 when config.bindless is supported, null otherwise.
+        // Each slot's object array is registered in it and the frame uniforms become push
+        // constants.
+        std::unique_ptr<TaraskBindlessTable> m_bindlessTable;
+        // per slot, into m_bindlessTable, baked into the cached scene commands like the offsets
+        std::vector<uint32_t> m_objectBufferIndices;
+        std::vector<std::unique_ptr<TaraskDrawList>> m_drawLists;
+        // null when the device cannot cull, m_drawLists draw everything then
+        std::unique_ptr<TaraskCullingPass> m_cullingPass;
+        std::unique_ptr<TaraskGeometryArena> m_geometryArena;
+        TaraskMesh m_triangleMesh;
+        // one object per instance, dense index i is written to instance i
+        TaraskScene m_scene;
+        uint32_t m_animationFrame = 0;
+        // clip position = (position + object offset) * scale + offset, for the vertex shaders
+        // and the culling pass alike. Baked into the cached scene commands on the bindless path.
+        glm::vec2 m_viewScale{1.0f, 1.0f};
+        glm::vec2 m_viewOffset{0.0f, 0.0f};
+        RunStats m_stats;
+        // null when the graphics queue cannot write timestamps
+        std::unique_ptr<TaraskGpuProfiler> m_gpuProfiler;
+        TaraskFrameLimiter m_frameLimiter;
+
+        std::thread m_renderThread;
+        // main thread to render thread, the render thread only keeps the newest
+        TaraskSpscQueue<FramePacket, 8> m_framePackets;
+        // set by the main thread once the window closes
+        std::atomic<bool> m_stopRendering{false};
+        // set by the render thread once it stopped on its own, after frameCount or an error
+        std::atomic<bool> m_renderingDone{false};
     };
 } // namespace tarask
\ No newline at end of file
@@ -1,15 +1,93 @@
 #include "first_app.hpp"
+#include "tarask_trace.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main()
+static bool parsePresentMode(const char *name, VkPresentModeKHR &mode)
 {
-    tarask::FirstApp app{};
+    if (std::strcmp(name, "fifo") == 0)
+    {
+        mode = VK_PRESENT_MODE_FIFO_KHR;
+    }
+    else if (std::strcmp(name, "fifo_relaxed") == 0)
+    {
+        mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    }
+    else if (std::strcmp(name, "mailbox") == 0)
+    {
+        mode = VK_PRESENT_MODE_MAILBOX_KHR;
+    }
+    else if (std::strcmp(name, "immediate") == 0)
+    {
+        mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    tarask::AppConfig config{};
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            config.headless = true;
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            config.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+        {
+            config.renderTarget.framesInFlight = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc &&
+                 parsePresentMode(argv[i + 1], config.renderTarget.presentMode))
+        {
+            i++;
+        }
+        else if (std::strcmp(argv[i], "--image-count") == 0 && i + 1 < argc)
+        {
+            config.renderTarget.imageCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc)
+        {
+            config.maxFps = std::stod(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--bindless") == 0)
+        {
+            config.bindless = true;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0]
+                      << " [--headless] [--frames N] [--frames-in-flight N]"
+                         " [--present-mode fifo|fifo_relaxed|mailbox|immediate]"
+                         " [--image-count N] [--max-fps N] [--bindless]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    // a headless run has no window to close, give it an end
+    if (config.headless && config.frameCount == 0)
+    {
+        config.frameCount = 1000;
+    }
+
+    TARASK_TRACE_THREAD("main");
+    tarask::FirstApp app{config};
     try
     {
         app.run();
+        TARASK_TRACE_DUMP("tarask_trace.json");
     }
     catch (const std::exception &e)
     {
@@ -17,4 +95,4 @@ int main()
         return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
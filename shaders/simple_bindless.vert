@@ -0,0 +1,31 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+struct ObjectData {
+    vec2 offset;
+    vec3 color;
+};
+
+// the bindless table's storage buffer array, every entry seen as an object array
+layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} buffers[];
+
+layout(push_constant) uniform Push {
+    vec2 viewScale;
+    vec2 viewOffset;
+    // index of this frame's object array in buffers
+    uint objectBuffer;
+} push;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // gl_InstanceIndex includes the draw's firstInstance, which is the object index
+    ObjectData object = buffers[nonuniformEXT(push.objectBuffer)].objects[gl_InstanceIndex];
+    gl_Position = vec4((position + object.offset) * push.viewScale + push.viewOffset, 0.0, 1.0);
+    fragColor = object.color;
+}
@@ -0,0 +1,28 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+// both bound with dynamic offsets into the per frame ring
+layout(set = 0, binding = 0) uniform FrameData {
+    vec2 viewScale;
+    vec2 viewOffset;
+} frame;
+
+struct ObjectData {
+    vec2 offset;
+    vec3 color;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // gl_InstanceIndex includes the draw's firstInstance, which is the object index
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_Position = vec4((position + object.offset) * frame.viewScale + frame.viewOffset, 0.0, 1.0);
+    fragColor = object.color;
+}
@@ -0,0 +1,466 @@
+#include "tarask_allocator.hpp"
+
+#include "tarask_device.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace tarask
+{
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static VkDeviceSize nextPowerOfTwo(VkDeviceSize value)
+    {
+        VkDeviceSize result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // A single VkDeviceMemory object. Subclasses decide how ranges inside of it are handed out.
+    class TaraskMemoryBlock
+    {
+    public:
+        TaraskMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void *mapped, bool dedicated)
+            : m_memory{memory}, m_size{size}, m_mapped{mapped}, m_dedicated{dedicated}
+        {
+        }
+        virtual ~TaraskMemoryBlock() = default;
+
+        TaraskMemoryBlock(const TaraskMemoryBlock &) = delete;
+        TaraskMemoryBlock &operator=(const TaraskMemoryBlock &) = delete;
+
+        bool allocate(VkDeviceSize size, VkDeviceSize alignment, TaraskAllocation &allocation)
+        {
+            VkDeviceSize offset;
+            if (!reserve(size, alignment, offset, allocation.reservedOffset,
+                         allocation.reservedSize))
+            {
+                return false;
+            }
+            allocation.memory = m_memory;
+            allocation.offset = offset;
+            allocation.size = size;
+            allocation.mappedData =
+                m_mapped == nullptr ? nullptr : static_cast<char *>(m_mapped) + offset;
+            allocation.block = this;
+            m_allocationCount++;
+            m_usedBytes += allocation.reservedSize;
+            return true;
+        }
+
+        void free(const TaraskAllocation &allocation)
+        {
+            assert(m_allocationCount > 0 && "TaraskMemoryBlock: double free.");
+            release(allocation.reservedOffset, allocation.reservedSize);
+            m_allocationCount--;
+            m_usedBytes -= allocation.reservedSize;
+        }
+
+        VkDeviceMemory memory() { return m_memory; }
+        VkDeviceSize size() { return m_size; }
+        VkDeviceSize usedBytes() { return m_usedBytes; }
+        uint32_t allocationCount() { return m_allocationCount; }
+        bool isDedicated() { return m_dedicated; }
+        bool isEmpty() { return m_allocationCount == 0; }
+
+    protected:
+        virtual bool reserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset,
+                             VkDeviceSize &reservedOffset, VkDeviceSize &reservedSize) = 0;
+        virtual void release(VkDeviceSize reservedOffset, VkDeviceSize reservedSize) = 0;
+
+        VkDeviceMemory m_memory;
+        VkDeviceSize m_size;
+        void *m_mapped;
+        bool m_dedicated;
+        uint32_t m_allocationCount = 0;
+        VkDeviceSize m_usedBytes = 0;
+    };
+
+    class LinearMemoryBlock : public TaraskMemoryBlock
+    {
+    public:
+        using TaraskMemoryBlock::TaraskMemoryBlock;
+
+    protected:
+        bool reserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset,
+                     VkDeviceSize &reservedOffset, VkDeviceSize &reservedSize) override
+        {
+            VkDeviceSize aligned = alignUp(m_head, alignment);
+            if (aligned + size > m_size)
+            {
+                return false;
+            }
+            offset = aligned;
+            reservedOffset = m_head;
+            reservedSize = aligned + size - m_head;
+            m_head = aligned + size;
+            return true;
+        }
+
+        void release(VkDeviceSize /*reservedOffset*/, VkDeviceSize /*reservedSize*/) override
+        {
+            // the last allocation going away rewinds the whole block
+            if (m_allocationCount == 1)
+            {
+                m_head = 0;
+            }
+        }
+
+    private:
+        VkDeviceSize m_head = 0;
+    };
+
+    class FreeListMemoryBlock : public TaraskMemoryBlock
+    {
+    public:
+        FreeListMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void *mapped, bool dedicated)
+            : TaraskMemoryBlock{memory, size, mapped, dedicated}
+        {
+            m_freeRanges[0] = size;
+        }
+
+    protected:
+        bool reserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset,
+                     VkDeviceSize &reservedOffset, VkDeviceSize &reservedSize) override
+        {
+            for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+            {
+                VkDeviceSize rangeOffset = it->first;
+                VkDeviceSize rangeSize = it->second;
+                VkDeviceSize aligned = alignUp(rangeOffset, alignment);
+                VkDeviceSize padding = aligned - rangeOffset;
+                if (padding + size > rangeSize)
+                {
+                    continue;
+                }
+
+                m_freeRanges.erase(it);
+                VkDeviceSize remaining = rangeSize - padding - size;
+                if (remaining > 0)
+                {
+                    m_freeRanges[aligned + size] = remaining;
+                }
+                offset = aligned;
+                reservedOffset = rangeOffset;
+                reservedSize = padding + size;
+                return true;
+            }
+            return false;
+        }
+
+        void release(VkDeviceSize reservedOffset, VkDeviceSize reservedSize) override
+        {
+            auto it = m_freeRanges.emplace(reservedOffset, reservedSize).first;
+
+            auto next = std::next(it);
+            if (next != m_freeRanges.end() && it->first + it->second == next->first)
+            {
+                it->second += next->second;
+                m_freeRanges.erase(next);
+            }
+            if (it != m_freeRanges.begin())
+            {
+                auto previous = std::prev(it);
+                if (previous->first + previous->second == it->first)
+                {
+                    previous->second += it->second;
+                    m_freeRanges.erase(it);
+                }
+            }
+        }
+
+    private:
+        std::map<VkDeviceSize, VkDeviceSize> m_freeRanges;
+    };
+
+    class BuddyMemoryBlock : public TaraskMemoryBlock
+    {
+    public:
+        static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+
+        BuddyMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, void *mapped, bool dedicated)
+            : TaraskMemoryBlock{memory, size, mapped, dedicated}
+        {
+            assert((size & (size - 1)) == 0 && "BuddyMemoryBlock: size must be a power of two.");
+            uint32_t orderCount = 1;
+            while ((MIN_NODE_SIZE << (orderCount - 1)) < size)
+            {
+                orderCount++;
+            }
+            m_freeNodes.resize(orderCount);
+            m_freeNodes.back().insert(0);
+        }
+
+    protected:
+        bool reserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset,
+                     VkDeviceSize &reservedOffset, VkDeviceSize &reservedSize) override
+        {
+            // nodes are aligned to their own size, which covers any power of two alignment
+            VkDeviceSize nodeSize = nextPowerOfTwo(std::max({size, alignment, MIN_NODE_SIZE}));
+            uint32_t order = orderOf(nodeSize);
+            if (order >= m_freeNodes.size())
+            {
+                return false;
+            }
+
+            uint32_t available = order;
+            while (available < m_freeNodes.size() && m_freeNodes[available].empty())
+            {
+                available++;
+            }
+            if (available == m_freeNodes.size())
+            {
+                return false;
+            }
+
+            VkDeviceSize nodeOffset = *m_freeNodes[available].begin();
+            m_freeNodes[available].erase(m_freeNodes[available].begin());
+            while (available > order)
+            {
+                available--;
+                m_freeNodes[available].insert(nodeOffset + (MIN_NODE_SIZE << available));
+            }
+
+            offset = nodeOffset;
+            reservedOffset = nodeOffset;
+            reservedSize = nodeSize;
+            return true;
+        }
+
+        void release(VkDeviceSize reservedOffset, VkDeviceSize reservedSize) override
+        {
+            uint32_t order = orderOf(reservedSize);
+            VkDeviceSize nodeOffset = reservedOffset;
+            while (order + 1 < m_freeNodes.size())
+            {
+                VkDeviceSize buddy = nodeOffset ^ (MIN_NODE_SIZE << order);
+                auto it = m_freeNodes[order].find(buddy);
+                if (it == m_freeNodes[order].end())
+                {
+                    break;
+                }
+                m_freeNodes[order].erase(it);
+                nodeOffset = std::min(nodeOffset, buddy);
+                order++;
+            }
+            m_freeNodes[order].insert(nodeOffset);
+        }
+
+    private:
+        static uint32_t orderOf(VkDeviceSize nodeSize)
+        {
+            uint32_t order = 0;
+            while ((MIN_NODE_SIZE << order) < nodeSize)
+            {
+                order++;
+            }
+            return order;
+        }
+
+        std::vector<std::set<VkDeviceSize>> m_freeNodes;
+    };
+
+    TaraskAllocator::TaraskAllocator(TaraskDevice &device) : m_taraskDevice{device}
+    {
+        vkGetPhysicalDeviceMemoryProperties(m_taraskDevice.getPhysicalDevice(),
+                                            &m_memoryProperties);
+    }
+
+    TaraskAllocator::~TaraskAllocator()
+    {
+        for (auto &pool : m_pools)
+        {
+            for (auto &block : pool.blocks)
+            {
+                assert(block->isEmpty() && "TaraskAllocator: memory block still in use.");
+                vkFreeMemory(m_taraskDevice.device(), block->memory(), nullptr);
+            }
+        }
+        for (auto &block : m_dedicatedBlocks)
+        {
+            vkFreeMemory(m_taraskDevice.device(), block->memory(), nullptr);
+        }
+    }
+
+    TaraskAllocation TaraskAllocator::allocate(const VkMemoryRequirements &requirements,
+                                               VkMemoryPropertyFlags properties,
+                                               ResourceKind kind, AllocationStrategy strategy)
+    {
+        uint32_t memoryTypeIndex =
+            m_taraskDevice.findMemoryType(requirements.memoryTypeBits, properties);
+        VkDeviceSize blockSize = preferredBlockSize(memoryTypeIndex);
+
+        std::lock_guard<std::mutex> lock{m_mutex};
+        TaraskAllocation allocation{};
+
+        // large resources get their own VkDeviceMemory instead of eating half a block
+        if (requirements.size > blockSize / 2)
+        {
+            auto block = createBlock(memoryTypeIndex, requirements.size, AllocationStrategy::Linear,
+                                     true);
+            block->allocate(requirements.size, requirements.alignment, allocation);
+            m_dedicatedBlocks.push_back(std::move(block));
+            return allocation;
+        }
+
+        Pool &pool = getPool(memoryTypeIndex, kind, strategy);
+        for (auto &block : pool.blocks)
+        {
+            if (block->allocate(requirements.size, requirements.alignment, allocation))
+            {
+                return allocation;
+            }
+        }
+
+        pool.blocks.push_back(createBlock(memoryTypeIndex, blockSize, strategy, false));
+        if (!pool.blocks.back()->allocate(requirements.size, requirements.alignment, allocation))
+        {
+            throw std::runtime_error("TaraskAllocator: failed to sub-allocate from a new block.");
+        }
+        return allocation;
+    }
+
+    void TaraskAllocator::free(TaraskAllocation &allocation)
+    {
+        if (allocation.block == nullptr)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{m_mutex};
+        TaraskMemoryBlock *block = allocation.block;
+        block->free(allocation);
+        allocation = TaraskAllocation{};
+
+        if (!block->isEmpty())
+        {
+            return;
+        }
+
+        if (block->isDedicated())
+        {
+            auto it = std::find_if(m_dedicatedBlocks.begin(), m_dedicatedBlocks.end(),
+                                   [block](const auto &b) { return b.get() == block; });
+            vkFreeMemory(m_taraskDevice.device(), block->memory(), nullptr);
+            m_dedicatedBlocks.erase(it);
+            return;
+        }
+
+        // keep one empty block around per pool so alloc/free patterns don't thrash
+        for (auto &pool : m_pools)
+        {
+            auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                                   [block](const auto &b) { return b.get() == block; });
+            if (it == pool.blocks.end())
+            {
+                continue;
+            }
+            bool hasOtherEmptyBlock =
+                std::any_of(pool.blocks.begin(), pool.blocks.end(), [block](const auto &b)
+                            { return b.get() != block && b->isEmpty(); });
+            if (hasOtherEmptyBlock)
+            {
+                vkFreeMemory(m_taraskDevice.device(), block->memory(), nullptr);
+                pool.blocks.erase(it);
+            }
+            return;
+        }
+    }
+
+    AllocatorStats TaraskAllocator::getStats()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        AllocatorStats stats{};
+        auto accumulate = [&stats](const std::unique_ptr<TaraskMemoryBlock> &block)
+        {
+            stats.blockCount++;
+            stats.allocationCount += block->allocationCount();
+            stats.blockBytes += block->size();
+            stats.usedBytes += block->usedBytes();
+        };
+        for (auto &pool : m_pools)
+        {
+            std::for_each(pool.blocks.begin(), pool.blocks.end(), accumulate);
+        }
+        std::for_each(m_dedicatedBlocks.begin(), m_dedicatedBlocks.end(), accumulate);
+        return stats;
+    }
+
+    TaraskAllocator::Pool &TaraskAllocator::getPool(uint32_t memoryTypeIndex, ResourceKind kind,
+                                                    AllocationStrategy strategy)
+    {
+        for (auto &pool : m_pools)
+        {
+            if (pool.memoryTypeIndex == memoryTypeIndex && pool.kind == kind &&
+                pool.strategy == strategy)
+            {
+                return pool;
+            }
+        }
+        m_pools.push_back(Pool{memoryTypeIndex, kind, strategy, {}});
+        return m_pools.back();
+    }
+
+    std::unique_ptr<TaraskMemoryBlock> TaraskAllocator::createBlock(uint32_t memoryTypeIndex,
+                                                                    VkDeviceSize size,
+                                                                    AllocationStrategy strategy,
+                                                                    bool dedicated)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(m_taraskDevice.device(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskAllocator: failed to allocate device memory block.");
+        }
+
+        void *mapped = nullptr;
+        if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vkMapMemory(m_taraskDevice.device(), memory, 0, VK_WHOLE_SIZE, 0, &mapped) !=
+                VK_SUCCESS)
+            {
+                vkFreeMemory(m_taraskDevice.device(), memory, nullptr);
+                throw std::runtime_error("TaraskAllocator: failed to map device memory block.");
+            }
+        }
+
+        switch (strategy)
+        {
+        case AllocationStrategy::Linear:
+            return std::make_unique<LinearMemoryBlock>(memory, size, mapped, dedicated);
+        case AllocationStrategy::Buddy:
+            return std::make_unique<BuddyMemoryBlock>(memory, size, mapped, dedicated);
+        case AllocationStrategy::FreeList:
+        default:
+            return std::make_unique<FreeListMemoryBlock>(memory, size, mapped, dedicated);
+        }
+    }
+
+    VkDeviceSize TaraskAllocator::preferredBlockSize(uint32_t memoryTypeIndex)
+    {
+        // small heaps (e.g. the 256MB host visible device local heap) get proportionally
+        // smaller blocks. Always a power of two so the buddy strategy can use it as is.
+        uint32_t heapIndex = m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+        VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE;
+        while (blockSize > heapSize / 8 && blockSize > 1024 * 1024)
+        {
+            blockSize >>= 1;
+        }
+        return blockSize;
+    }
+} // namespace tarask
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tarask
+{
+    class TaraskDevice;
+    class TaraskMemoryBlock;
+
+    enum class AllocationStrategy
+    {
+        // Bump allocation. Space is only reclaimed once every allocation of the block is freed.
+        Linear,
+        // First fit over a sorted list of free ranges, adjacent ranges are merged on free.
+        FreeList,
+        // Power of two buddy system, fast and with bounded fragmentation.
+        Buddy
+    };
+
+    // Buffers and linear images must not share a bufferImageGranularity page with optimal
+    // images, so the allocator keeps them in separate blocks.
+    enum class ResourceKind
+    {
+        Linear,
+        Optimal
+    };
+
+    // Lightweight handle to a range of device memory owned by the allocator.
+    struct TaraskAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Persistently mapped pointer to offset, only set for host visible memory.
+        void *mappedData = nullptr;
+
+        // Bookkeeping used to give the range back to its block.
+        TaraskMemoryBlock *block = nullptr;
+        VkDeviceSize reservedOffset = 0;
+        VkDeviceSize reservedSize = 0;
+
+        bool isValid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    struct AllocatorStats
+    {
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize blockBytes = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+
+    class TaraskAllocator
+    {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        TaraskAllocator(TaraskDevice &device);
+        ~TaraskAllocator();
+
+        TaraskAllocator(const TaraskAllocator &) = delete;
+        TaraskAllocator &operator=(const TaraskAllocator &) = delete;
+
+        TaraskAllocation allocate(const VkMemoryRequirements &requirements,
+                                  VkMemoryPropertyFlags properties, ResourceKind kind,
+                                  AllocationStrategy strategy = AllocationStrategy::FreeList);
+        void free(TaraskAllocation &allocation);
+
+        AllocatorStats getStats();
+
+    private:
+        struct Pool
+        {
+            uint32_t memoryTypeIndex;
+            ResourceKind kind;
+            AllocationStrategy strategy;
+            std::vector<std::unique_ptr<TaraskMemoryBlock>> blocks;
+        };
+
+        Pool &getPool(uint32_t memoryTypeIndex, ResourceKind kind, AllocationStrategy strategy);
+        std::unique_ptr<TaraskMemoryBlock> createBlock(uint32_t memoryTypeIndex, VkDeviceSize size,
+                                                       AllocationStrategy strategy, bool dedicated);
+        VkDeviceSize preferredBlockSize(uint32_t memoryTypeIndex);
+
+        TaraskDevice &m_taraskDevice;
+        VkPhysicalDeviceMemoryProperties m_memoryProperties;
+        std::vector<Pool> m_pools;
+        std::vector<std::unique_ptr<TaraskMemoryBlock>> m_dedicatedBlocks;
+        std::mutex m_mutex;
+    };
+} // namespace tarask
@@ -0,0 +1,164 @@
+#include "tarask_bindless.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tarask
+{
+    namespace
+    {
+        constexpr VkDescriptorBindingFlags BINDLESS_BINDING_FLAGS =
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+        // an empty array is not allowed in a layout
+        uint32_t clampCount(uint32_t count, uint32_t perStageLimit, uint32_t perSetLimit)
+        {
+            return std::max(std::min({count, perStageLimit, perSetLimit}), 1u);
+        }
+    } // namespace
+
+    uint32_t TaraskBindlessTable::Slots::acquire(const char *fullMessage)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!freeIndices.empty())
+        {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return index;
+        }
+        if (next == capacity)
+        {
+            throw std::runtime_error(fullMessage);
+        }
+        return next++;
+    }
+
+    void TaraskBindlessTable::Slots::release(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        freeIndices.push_back(index);
+    }
+
+    TaraskBindlessTable::TaraskBindlessTable(TaraskDevice &device, uint32_t maxStorageBuffers,
+                                             uint32_t maxSampledImages)
+        : m_taraskDevice{device}
+    {
+        if (!isSupported(device))
+        {
+            throw std::runtime_error("TaraskBindlessTable: descriptor indexing not supported.");
+        }
+
+        const auto &limits = device.descriptorIndexingProperties();
+        m_storageBuffers = std::make_shared<Slots>(
+            clampCount(maxStorageBuffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                       limits.maxDescriptorSetUpdateAfterBindStorageBuffers));
+        m_sampledImages = std::make_shared<Slots>(
+            clampCount(maxSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                       limits.maxDescriptorSetUpdateAfterBindSampledImages));
+
+        m_setLayout =
+            TaraskDescriptorSetLayout::Builder(device)
+                .addBinding(STORAGE_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                            VK_SHADER_STAGE_ALL, m_storageBuffers->capacity,
+                            BINDLESS_BINDING_FLAGS)
+                .addBinding(SAMPLED_IMAGE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                            VK_SHADER_STAGE_ALL, m_sampledImages->capacity, BINDLESS_BINDING_FLAGS)
+                .setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+                .build();
+        m_pool = TaraskDescriptorPool::Builder(device)
+                     .setMaxSets(1)
+                     .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+                     .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_storageBuffers->capacity)
+                     .addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_sampledImages->capacity)
+                     .build();
+        if (!m_pool->allocateDescriptor(m_setLayout->getDescriptorSetLayout(), m_set))
+        {
+            throw std::runtime_error("TaraskBindlessTable: failed to allocate descriptor set.");
+        }
+    }
+
+    // the set goes with the pool, both through the deletion queue
+    TaraskBindlessTable::~TaraskBindlessTable() = default;
+
+    uint32_t TaraskBindlessTable::addStorageBuffer(VkBuffer buffer, VkDeviceSize offset,
+                                                   VkDeviceSize range)
+    {
+        uint32_t index =
+            m_storageBuffers->acquire("TaraskBindlessTable: storage buffer array is full.");
+        updateStorageBuffer(index, buffer, offset, range);
+        return index;
+    }
+
+    uint32_t TaraskBindlessTable::addSampledImage(VkImageView imageView, VkImageLayout imageLayout)
+    {
+        uint32_t index =
+            m_sampledImages->acquire("TaraskBindlessTable: sampled image array is full.");
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageView = imageView;
+        imageInfo.imageLayout = imageLayout;
+        write(SAMPLED_IMAGE_BINDING, index, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, nullptr,
+              &imageInfo);
+        return index;
+    }
+
+    void TaraskBindlessTable::updateStorageBuffer(uint32_t index, VkBuffer buffer,
+                                                  VkDeviceSize offset, VkDeviceSize range)
+    {
+        if (index >= m_storageBuffers->capacity)
+        {
+            throw std::runtime_error("TaraskBindlessTable: storage buffer index out of range.");
+        }
+        VkDescriptorBufferInfo bufferInfo{buffer, offset, range};
+        write(STORAGE_BUFFER_BINDING, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, &bufferInfo,
+              nullptr);
+    }
+
+    void TaraskBindlessTable::releaseStorageBuffer(uint32_t index)
+    {
+        deferRelease(m_storageBuffers, index);
+    }
+
+    void TaraskBindlessTable::releaseSampledImage(uint32_t index)
+    {
+        deferRelease(m_sampledImages, index);
+    }
+
+    void TaraskBindlessTable::bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint,
+                                   VkPipelineLayout pipelineLayout, uint32_t setIndex) const
+    {
+        vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setIndex, 1, &m_set, 0,
+                                nullptr);
+    }
+
+    void TaraskBindlessTable::write(uint32_t binding, uint32_t index,
+                                    VkDescriptorType descriptorType,
+                                    const VkDescriptorBufferInfo *bufferInfo,
+                                    const VkDescriptorImageInfo *imageInfo)
+    {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_set;
+        write.dstBinding = binding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = descriptorType;
+        write.pBufferInfo = bufferInfo;
+        write.pImageInfo = imageInfo;
+
+        std::lock_guard<std::mutex> lock{m_writeMutex};
+        vkUpdateDescriptorSets(m_taraskDevice.device(), 1, &write, 0, nullptr);
+    }
+
+    void TaraskBindlessTable::deferRelease(const std::shared_ptr<Slots> &slots, uint32_t index)
+    {
+        if (index >= slots->capacity)
+        {
+            throw std::runtime_error("TaraskBindlessTable: index out of range.");
+        }
+        // frames recorded so far may still read the old descriptor, the entry stays as it is
+        // and only becomes reusable once they completed
+        m_taraskDevice.deletionQueue().enqueue([slots, index]() { slots->release(index); });
+    }
+} // namespace tarask
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "tarask_descriptors.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tarask
+{
+    // One descriptor set holding large arrays of storage buffers and sampled images, bound once
+    // and indexed from shaders by the uint32_t a resource was registered under. Shaders get the
+    // indices through push constants or object data, so switching resources never touches
+    // descriptor sets. Needs TaraskDevice::supportsDescriptorIndexing(), callers keep their
+    // ordinary descriptor sets as the fallback without it.
+    //
+    // Set layout, in GLSL with GL_EXT_nonuniform_qualifier:
+    //   layout(set = N, binding = 0) buffer ... buffers[];
+    //   layout(set = N, binding = 1) uniform texture2D images[];
+    //
+    // The arrays are update after bind and partially bound, so entries can be written while
+    // frames using other entries are in flight and unused entries may stay empty. A released
+    // index is only handed out again once the frames recorded before the release completed.
+    class TaraskBindlessTable
+    {
+    public:
+        static constexpr uint32_t STORAGE_BUFFER_BINDING = 0;
+        static constexpr uint32_t SAMPLED_IMAGE_BINDING = 1;
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        // The counts are clamped to the device's update after bind limits.
+        TaraskBindlessTable(TaraskDevice &device, uint32_t maxStorageBuffers,
+                            uint32_t maxSampledImages);
+        ~TaraskBindlessTable();
+
+        TaraskBindlessTable(const TaraskBindlessTable &) = delete;
+        TaraskBindlessTable &operator=(const TaraskBindlessTable &) = delete;
+
+        static bool isSupported(TaraskDevice &device)
+        {
+            return device.supportsDescriptorIndexing();
+        }
+
+        // Registered resources must outlive their index. All of these may be called from any
+        // thread, throw once the array is full.
+        uint32_t addStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+        uint32_t addSampledImage(VkImageView imageView, VkImageLayout imageLayout);
+        // Only for an index no pending frame reads.
+        void updateStorageBuffer(uint32_t index, VkBuffer buffer, VkDeviceSize offset,
+                                 VkDeviceSize range);
+        void releaseStorageBuffer(uint32_t index);
+        void releaseSampledImage(uint32_t index);
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const
+        {
+            return m_setLayout->getDescriptorSetLayout();
+        }
+        void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint,
+                  VkPipelineLayout pipelineLayout, uint32_t setIndex) const;
+
+        uint32_t storageBufferCapacity() const { return m_storageBuffers->capacity; }
+        uint32_t sampledImageCapacity() const { return m_sampledImages->capacity; }
+
+    private:
+        // Free list over one array. Shared with the deletion queue entries that return released
+        // indices, which may run after the table is gone.
+        struct Slots
+        {
+            explicit Slots(uint32_t count) : capacity{count} {}
+
+            uint32_t acquire(const char *fullMessage);
+            void release(uint32_t index);
+
+            const uint32_t capacity;
+            std::mutex mutex;
+            std::vector<uint32_t> freeIndices;
+            // below this every index has been handed out at least once
+            uint32_t next = 0;
+        };
+
+        void write(uint32_t binding, uint32_t index, VkDescriptorType descriptorType,
+                   const VkDescriptorBufferInfo *bufferInfo,
+                   const VkDescriptorImageInfo *imageInfo);
+        void deferRelease(const std::shared_ptr<Slots> &slots, uint32_t index);
+
+        TaraskDevice &m_taraskDevice;
+        std::shared_ptr<Slots> m_storageBuffers;
+        std::shared_ptr<Slots> m_sampledImages;
+        std::unique_ptr<TaraskDescriptorSetLayout> m_setLayout;
+        std::unique_ptr<TaraskDescriptorPool> m_pool;
+        VkDescriptorSet m_set = VK_NULL_HANDLE;
+        // writes to the set need external synchronization
+        std::mutex m_writeMutex;
+    };
+} // namespace tarask
@@ -0,0 +1,77 @@
+#include "tarask_command_cache.hpp"
+
+#include "tarask_trace.hpp"
+
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskCommandCache::TaraskCommandCache(TaraskDevice &device, TaraskJobSystem &jobs,
+                                           uint32_t slotCount)
+        : m_jobs{jobs}, m_pools{device, jobs.threadCount(), slotCount},
+          m_slots(slotCount)
+    {
+    }
+
+    void TaraskCommandCache::markDirty()
+    {
+        for (auto &slot : m_slots)
+        {
+            slot.dirty = true;
+        }
+    }
+
+    const std::vector<VkCommandBuffer> &
+    TaraskCommandCache::get(uint32_t slotIndex, VkRenderPass renderPass,
+                            VkQueryPipelineStatisticFlags pipelineStatistics, uint32_t chunkCount,
+                            const std::function<void(VkCommandBuffer, uint32_t)> &record)
+    {
+        Slot &slot = m_slots[slotIndex];
+        if (!slot.dirty && slot.commandBuffers.size() == chunkCount)
+        {
+            return slot.commandBuffers;
+        }
+
+        TARASK_TRACE_SCOPE("recordSecondaries");
+        // the frame that executed them has completed, so the whole slot is recycled at once
+        m_pools.reset(slotIndex);
+        slot.commandBuffers.assign(chunkCount, VK_NULL_HANDLE);
+
+        // no framebuffer, so a resize that keeps the render pass only changes the extent
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+        inheritanceInfo.pipelineStatistics = pipelineStatistics;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        m_jobs.parallelFor(
+            chunkCount,
+            [&](uint32_t chunk, uint32_t thread)
+            {
+                TARASK_TRACE_SCOPE("recordChunk");
+                VkCommandBuffer commandBuffer = m_pools.secondary(slotIndex, thread);
+                if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+                {
+                    throw std::runtime_error(
+                        "TaraskCommandCache: failed to begin secondary command buffer.");
+                }
+                record(commandBuffer, chunk);
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+                {
+                    throw std::runtime_error(
+                        "TaraskCommandCache: failed to record secondary command buffer.");
+                }
+                slot.commandBuffers[chunk] = commandBuffer;
+            });
+
+        slot.dirty = false;
+        m_recordCount++;
+        return slot.commandBuffers;
+    }
+} // namespace tarask
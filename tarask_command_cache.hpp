@@ -0,0 +1,58 @@
+#pragma once
+
+#include "tarask_command_pools.hpp"
+#include "tarask_device.hpp"
+#include "tarask_job_system.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace tarask
+{
+    // Secondary command buffers recorded once and replayed by every later frame through
+    // vkCmdExecuteCommands. Each slot matches one primary command buffer, so a slot is only
+    // re-recorded once the render target has waited for the frame that last executed it.
+    // Slots stay valid until markDirty(), call it whenever something baked into the recorded
+    // commands changes: the pipeline, the bound buffers, draw counts or the extent.
+    //
+    // A slot is split into chunks recorded in parallel on the job system, each thread into
+    // command buffers from its own pool for that slot.
+    class TaraskCommandCache
+    {
+    public:
+        TaraskCommandCache(TaraskDevice &device, TaraskJobSystem &jobs, uint32_t slotCount);
+
+        TaraskCommandCache(const TaraskCommandCache &) = delete;
+        TaraskCommandCache &operator=(const TaraskCommandCache &) = delete;
+
+        void markDirty();
+        void markDirty(uint32_t slot) { m_slots[slot].dirty = true; }
+        bool isDirty(uint32_t slot) const { return m_slots[slot].dirty; }
+
+        // Returns the slot's secondary command buffers in chunk order, recorded inside
+        // renderPass first if the slot is dirty or the chunk count changed. record(commands,
+        // chunk) runs once per chunk, on any job thread. pipelineStatistics must cover the
+        // statistics query that is active around vkCmdExecuteCommands, if any.
+        const std::vector<VkCommandBuffer> &
+        get(uint32_t slot, VkRenderPass renderPass,
+            VkQueryPipelineStatisticFlags pipelineStatistics, uint32_t chunkCount,
+            const std::function<void(VkCommandBuffer, uint32_t)> &record);
+
+        // how many times any slot was recorded, to check the cache is actually hit
+        uint64_t recordCount() const { return m_recordCount; }
+
+    private:
+        struct Slot
+        {
+            std::vector<VkCommandBuffer> commandBuffers;
+            bool dirty = true;
+        };
+
+        TaraskJobSystem &m_jobs;
+        TaraskCommandPools m_pools;
+        std::vector<Slot> m_slots;
+        uint64_t m_recordCount = 0;
+    };
+} // namespace tarask
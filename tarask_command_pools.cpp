@@ -0,0 +1,73 @@
+#include "tarask_command_pools.hpp"
+
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskCommandPools::TaraskCommandPools(TaraskDevice &device, uint32_t threadCount,
+                                           uint32_t frameCount)
+        : m_taraskDevice{device}, m_threadCount{threadCount}, m_pools(threadCount * frameCount)
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = m_taraskDevice.findPhysicalQueueFamilies().graphicsFamily;
+        // recycled as a whole, never one command buffer at a time
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        for (auto &pool : m_pools)
+        {
+            if (vkCreateCommandPool(m_taraskDevice.device(), &poolInfo, nullptr, &pool.pool) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error("TaraskCommandPools: failed to create command pool.");
+            }
+        }
+    }
+
+    TaraskCommandPools::~TaraskCommandPools()
+    {
+        // destroying a pool frees its command buffers, pending frames may still execute them
+        VkDevice device = m_taraskDevice.device();
+        for (auto &pool : m_pools)
+        {
+            m_taraskDevice.deletionQueue().enqueue(
+                [device, commandPool = pool.pool]()
+                { vkDestroyCommandPool(device, commandPool, nullptr); });
+        }
+    }
+
+    void TaraskCommandPools::reset(uint32_t frame)
+    {
+        for (uint32_t thread = 0; thread < m_threadCount; thread++)
+        {
+            Pool &framePool = pool(frame, thread);
+            if (framePool.used == 0)
+            {
+                continue;
+            }
+            vkResetCommandPool(m_taraskDevice.device(), framePool.pool, 0);
+            framePool.used = 0;
+        }
+    }
+
+    VkCommandBuffer TaraskCommandPools::secondary(uint32_t frame, uint32_t thread)
+    {
+        Pool &framePool = pool(frame, thread);
+        if (framePool.used == framePool.secondaries.size())
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = framePool.pool;
+            allocInfo.commandBufferCount = 1;
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(m_taraskDevice.device(), &allocInfo, &commandBuffer) !=
+                VK_SUCCESS)
+            {
+                throw std::runtime_error(
+                    "TaraskCommandPools: failed to allocate secondary command buffer.");
+            }
+            framePool.secondaries.push_back(commandBuffer);
+        }
+        return framePool.secondaries[framePool.used++];
+    }
+} // namespace tarask
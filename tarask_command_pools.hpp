@@ -0,0 +1,51 @@
+#pragma once
+
+#include "tarask_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <vector>
+
+namespace tarask
+{
+    // One graphics command pool per recording thread and frame. A pool must only be used by
+    // one thread at a time, so giving every thread its own lets them record without locks,
+    // and one pool per frame lets a whole frame's command buffers be recycled with a single
+    // vkResetCommandPool once that frame has completed.
+    class TaraskCommandPools
+    {
+    public:
+        TaraskCommandPools(TaraskDevice &device, uint32_t threadCount, uint32_t frameCount);
+        ~TaraskCommandPools();
+
+        TaraskCommandPools(const TaraskCommandPools &) = delete;
+        TaraskCommandPools &operator=(const TaraskCommandPools &) = delete;
+
+        uint32_t threadCount() const { return m_threadCount; }
+
+        // Recycles every command buffer handed out for frame. The frame's last submission
+        // must have completed and no other thread may be recording into it.
+        void reset(uint32_t frame);
+        // A secondary command buffer from the pool of thread and frame, reused after reset().
+        // Only thread may call it for its own pools.
+        VkCommandBuffer secondary(uint32_t frame, uint32_t thread);
+
+    private:
+        struct Pool
+        {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> secondaries;
+            // secondaries handed out since the last reset
+            uint32_t used = 0;
+        };
+
+        Pool &pool(uint32_t frame, uint32_t thread)
+        {
+            return m_pools[frame * m_threadCount + thread];
+        }
+
+        TaraskDevice &m_taraskDevice;
+        uint32_t m_threadCount;
+        std::vector<Pool> m_pools;
+    };
+} // namespace tarask
@@ -0,0 +1,58 @@
+#include "tarask_compute_pipeline.hpp"
+
+#include "tarask_pipeline.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskComputePipeline::TaraskComputePipeline(TaraskDevice &device,
+                                                 const std::string &computeShaderPath,
+                                                 VkPipelineLayout pipelineLayout)
+        : m_taraskDevice{device}
+    {
+        assert(pipelineLayout != VK_NULL_HANDLE &&
+               "TaraskComputePipeline: Cannot create compute pipeline:: no pipelineLayout "
+               "provided.");
+
+        auto code = TaraskPipeline::readFile(computeShaderPath);
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        if (vkCreateShaderModule(m_taraskDevice.device(), &moduleInfo, nullptr,
+                                 &m_computeShaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskComputePipeline: failed to create shader module.");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = m_computeShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        if (m_taraskDevice.pipelineCache().createComputePipeline(pipelineInfo,
+                                                                 &m_computePipeline) != VK_SUCCESS)
+        {
+            vkDestroyShaderModule(m_taraskDevice.device(), m_computeShaderModule, nullptr);
+            throw std::runtime_error("TaraskComputePipeline: Failed to create compute pipeline.");
+        }
+    }
+
+    TaraskComputePipeline::~TaraskComputePipeline()
+    {
+        m_taraskDevice.deletionQueue().destroyShaderModule(m_computeShaderModule);
+        m_taraskDevice.deletionQueue().destroyPipeline(m_computePipeline);
+    }
+
+    void TaraskComputePipeline::bind(VkCommandBuffer commandBuffer)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline);
+    }
+} // namespace tarask
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "tarask_device.hpp"
+
+// std lib headers
+#include <string>
+
+namespace tarask
+{
+    // Sibling of TaraskPipeline for a single compute shader. The layout stays owned by the
+    // caller, like PipelineConfigInfo::pipelineLayout does for graphics pipelines.
+    class TaraskComputePipeline
+    {
+    public:
+        TaraskComputePipeline(TaraskDevice &device, const std::string &computeShaderPath,
+                              VkPipelineLayout pipelineLayout);
+        ~TaraskComputePipeline();
+
+        TaraskComputePipeline(const TaraskComputePipeline &) = delete;
+        TaraskComputePipeline &operator=(const TaraskComputePipeline &) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        TaraskDevice &m_taraskDevice;
+        VkPipeline m_computePipeline;
+        VkShaderModule m_computeShaderModule;
+    };
+} // namespace tarask
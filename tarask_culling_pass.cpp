@@ -0,0 +1,297 @@
+#include "tarask_culling_pass.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace tarask
+{
+    namespace
+    {
+        constexpr uint32_t WORKGROUP_SIZE = 64;
+
+        // matches Push in shaders/cull.comp
+        struct CullPushConstants
+        {
+            glm::vec2 viewScale;
+            glm::vec2 viewOffset;
+            glm::vec2 viewportSize;
+            float minPixelRadius;
+            uint32_t objectCount;
+        };
+    } // namespace
+
+    TaraskCullingPass::TaraskCullingPass(TaraskDevice &device, uint32_t maxObjects,
+                                         uint32_t frameCount)
+        : m_taraskDevice{device}, m_maxObjects{maxObjects}
+    {
+        createDescriptorSetLayout();
+        createPipelineLayout();
+        m_cullPipeline = std::make_unique<TaraskComputePipeline>(
+            m_taraskDevice, "shaders/cull.comp.spv", m_pipelineLayout);
+        createFrameResources(frameCount);
+    }
+
+    TaraskCullingPass::~TaraskCullingPass()
+    {
+        TaraskDeletionQueue &deletionQueue = m_taraskDevice.deletionQueue();
+        for (auto &frame : m_frames)
+        {
+            deletionQueue.destroyBuffer(frame.objectBuffer, frame.objectAllocation);
+            deletionQueue.destroyBuffer(frame.commandBuffer, frame.commandAllocation);
+            deletionQueue.destroyBuffer(frame.countBuffer, frame.countAllocation);
+        }
+        m_cullPipeline.reset();
+        deletionQueue.destroyPipelineLayout(m_pipelineLayout);
+        VkDevice device = m_taraskDevice.device();
+        deletionQueue.enqueue(
+            [device, descriptorPool = m_descriptorPool, setLayout = m_descriptorSetLayout]()
+            {
+                vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+                vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+            });
+    }
+
+    void TaraskCullingPass::createDescriptorSetLayout()
+    {
+        // objects in, compacted commands and their count out
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if (vkCreateDescriptorSetLayout(m_taraskDevice.device(), &layoutInfo, nullptr,
+                                        &m_descriptorSetLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskCullingPass: failed to create descriptor set layout.");
+        }
+    }
+
+    void TaraskCullingPass::createPipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(m_taraskDevice.device(), &pipelineLayoutInfo, nullptr,
+                                   &m_pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskCullingPass: failed to create pipeline layout.");
+        }
+    }
+
+    void TaraskCullingPass::createFrameResources(uint32_t frameCount)
+    {
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 3 * frameCount;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = frameCount;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if (vkCreateDescriptorPool(m_taraskDevice.device(), &poolInfo, nullptr,
+                                   &m_descriptorPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskCullingPass: failed to create descriptor pool.");
+        }
+
+        VkDeviceSize objectSize = sizeof(CullObject) * VkDeviceSize{m_maxObjects};
+        VkDeviceSize commandSize = sizeof(VkDrawIndexedIndirectCommand) * VkDeviceSize{m_maxObjects};
+        m_frames.resize(frameCount);
+        for (auto &frame : m_frames)
+        {
+            m_taraskDevice.createBuffer(objectSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                        frame.objectBuffer, frame.objectAllocation);
+            if (frame.objectAllocation.mappedData == nullptr)
+            {
+                throw std::runtime_error("TaraskCullingPass: object memory is not mapped.");
+            }
+            m_taraskDevice.createBuffer(commandSize,
+                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.commandBuffer,
+                                        frame.commandAllocation);
+            m_taraskDevice.createBuffer(sizeof(uint32_t),
+                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.countBuffer,
+                                        frame.countAllocation);
+
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = m_descriptorPool;
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &m_descriptorSetLayout;
+            if (vkAllocateDescriptorSets(m_taraskDevice.device(), &allocInfo,
+                                         &frame.descriptorSet) != VK_SUCCESS)
+            {
+                throw std::runtime_error("TaraskCullingPass: failed to allocate descriptor set.");
+            }
+
+            std::array<VkDescriptorBufferInfo, 3> bufferInfos{};
+            bufferInfos[0] = {frame.objectBuffer, 0, VK_WHOLE_SIZE};
+            bufferInfos[1] = {frame.commandBuffer, 0, VK_WHOLE_SIZE};
+            bufferInfos[2] = {frame.countBuffer, 0, VK_WHOLE_SIZE};
+            std::array<VkWriteDescriptorSet, 3> writes{};
+            for (uint32_t i = 0; i < writes.size(); i++)
+            {
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].dstSet = frame.descriptorSet;
+                writes[i].dstBinding = i;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[i].pBufferInfo = &bufferInfos[i];
+            }
+            vkUpdateDescriptorSets(m_taraskDevice.device(), static_cast<uint32_t>(writes.size()),
+                                   writes.data(), 0, nullptr);
+        }
+    }
+
+    void TaraskCullingPass::beginFrame(uint32_t frameIndex)
+    {
+        m_frameIndex = frameIndex;
+        m_objectCount = 0;
+    }
+
+    void TaraskCullingPass::addObject(const TaraskMesh &mesh, glm::vec2 offset,
+                                      uint32_t firstInstance, uint32_t instanceCount)
+    {
+        setObject(addObjects(1), mesh, offset, firstInstance, instanceCount);
+    }
+
+    uint32_t TaraskCullingPass::addObjects(uint32_t count)
+    {
+        if (count > m_maxObjects - m_objectCount)
+        {
+            throw std::runtime_error("TaraskCullingPass: too many objects.");
+        }
+        uint32_t first = m_objectCount;
+        m_objectCount += count;
+        return first;
+    }
+
+    void TaraskCullingPass::setObject(uint32_t index, const TaraskMesh &mesh, glm::vec2 offset,
+                                      uint32_t firstInstance, uint32_t instanceCount)
+    {
+        auto *objects = static_cast<CullObject *>(m_frames[m_frameIndex].objectAllocation.mappedData);
+        CullObject &object = objects[index];
+        object.center = mesh.boundsCenter + offset;
+        object.radius = mesh.boundsRadius;
+        object.indexCount = mesh.indexCount;
+        object.firstIndex = mesh.firstIndex;
+        object.vertexOffset = mesh.vertexOffset;
+        object.firstInstance = firstInstance;
+        object.instanceCount = instanceCount;
+    }
+
+    void TaraskCullingPass::dispatch(VkCommandBuffer commandBuffer, VkExtent2D viewportExtent)
+    {
+        auto &frame = m_frames[m_frameIndex];
+
+        // without a GPU side draw count every slot up to m_objectCount is drawn, so the ones
+        // the shader leaves alone must read as empty draws
+        vkCmdFillBuffer(commandBuffer, frame.countBuffer, 0, sizeof(uint32_t), 0);
+        if (!m_taraskDevice.supportsDrawIndirectCount())
+        {
+            vkCmdFillBuffer(commandBuffer, frame.commandBuffer, 0, VK_WHOLE_SIZE, 0);
+        }
+
+        VkMemoryBarrier clearBarrier{};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0,
+                             nullptr, 0, nullptr);
+
+        if (m_objectCount > 0)
+        {
+            m_cullPipeline->bind(commandBuffer);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                    m_pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+            CullPushConstants push{};
+            push.viewScale = m_viewScale;
+            push.viewOffset = m_viewOffset;
+            push.viewportSize = {static_cast<float>(viewportExtent.width),
+                                 static_cast<float>(viewportExtent.height)};
+            push.minPixelRadius = m_minPixelRadius;
+            push.objectCount = m_objectCount;
+            vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                               sizeof(CullPushConstants), &push);
+            vkCmdDispatch(commandBuffer, (m_objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1,
+                          1);
+        }
+
+        VkMemoryBarrier cullBarrier{};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cullBarrier, 0, nullptr, 0,
+                             nullptr);
+    }
+
+    void TaraskCullingPass::draw(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)
+    {
+        first = std::min(first, m_objectCount);
+        const uint32_t end = first + std::min(count, m_objectCount - first);
+        if (first == end)
+        {
+            return;
+        }
+        auto &frame = m_frames[m_frameIndex];
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        if (m_taraskDevice.supportsDrawIndirectCount())
+        {
+            assert(first == 0 && end == m_objectCount &&
+                   "TaraskCullingPass: compacted draws cannot be split, see canSplitDraws()");
+            m_taraskDevice.cmdDrawIndexedIndirectCount(commandBuffer, frame.commandBuffer, 0,
+                                                       frame.countBuffer, 0, m_objectCount,
+                                                       stride);
+            return;
+        }
+
+        // culled slots were zeroed in dispatch() and draw nothing
+        if (!m_taraskDevice.supportsMultiDrawIndirect())
+        {
+            for (uint32_t i = first; i < end; i++)
+            {
+                vkCmdDrawIndexedIndirect(commandBuffer, frame.commandBuffer,
+                                         VkDeviceSize{i} * stride, 1, stride);
+            }
+            return;
+        }
+
+        uint32_t maxDrawCount = m_taraskDevice.properties.limits.maxDrawIndirectCount;
+        for (uint32_t batch = first; batch < end; batch += maxDrawCount)
+        {
+            uint32_t batchCount = std::min(maxDrawCount, end - batch);
+            vkCmdDrawIndexedIndirect(commandBuffer, frame.commandBuffer,
+                                     VkDeviceSize{batch} * stride, batchCount, stride);
+        }
+    }
+} // namespace tarask
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "tarask_compute_pipeline.hpp"
+#include "tarask_device.hpp"
+#include "tarask_geometry_arena.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace tarask
+{
+    // One cullable draw, laid out to match the CullObject struct in shaders/cull.comp.
+    struct CullObject
+    {
+        glm::vec2 center;
+        float radius;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    // Tests every object's bounding circle against the view and its size in pixels on the
+    // GPU, and compacts the survivors into an indirect argument buffer. Objects are written
+    // by the CPU each frame, so every frame slot has its own buffers and descriptor set.
+    class TaraskCullingPass
+    {
+    public:
+        TaraskCullingPass(TaraskDevice &device, uint32_t maxObjects, uint32_t frameCount);
+        ~TaraskCullingPass();
+
+        TaraskCullingPass(const TaraskCullingPass &) = delete;
+        TaraskCullingPass &operator=(const TaraskCullingPass &) = delete;
+
+        // Culled draws carry a per object firstInstance, which indirect draws only honour with
+        // drawIndirectFirstInstance. Draw everything from a TaraskDrawList otherwise.
+        static bool isSupported(TaraskDevice &device)
+        {
+            return device.supportsDrawIndirectFirstInstance();
+        }
+
+        void setMinPixelRadius(float minPixelRadius) { m_minPixelRadius = minPixelRadius; }
+        // The transform the vertex shaders apply after the object offset, clip position =
+        // (position + offset) * scale + viewOffset. Read by the next dispatch.
+        void setView(glm::vec2 scale, glm::vec2 offset)
+        {
+            m_viewScale = scale;
+            m_viewOffset = offset;
+        }
+
+        void beginFrame(uint32_t frameIndex);
+        void addObject(const TaraskMesh &mesh, glm::vec2 offset, uint32_t firstInstance,
+                       uint32_t instanceCount = 1);
+        // Adds count objects at once and returns the index of the first, which setObject then
+        // fills in. Distinct indices can be set from different threads.
+        uint32_t addObjects(uint32_t count);
+        void setObject(uint32_t index, const TaraskMesh &mesh, glm::vec2 offset,
+                       uint32_t firstInstance, uint32_t instanceCount = 1);
+        // Records the culling dispatch, must be outside of a render pass.
+        void dispatch(VkCommandBuffer commandBuffer, VkExtent2D viewportExtent);
+        // Draws the surviving objects among [first, first + count) of those added this frame,
+        // all of them by default. The geometry arena must already be bound.
+        void draw(VkCommandBuffer commandBuffer, uint32_t first = 0, uint32_t count = UINT32_MAX);
+        uint32_t drawCount() const { return m_objectCount; }
+        // With VK_KHR_draw_indirect_count the survivors are compacted behind a single count,
+        // which one draw call has to consume whole.
+        bool canSplitDraws() { return !m_taraskDevice.supportsDrawIndirectCount(); }
+
+    private:
+        struct FrameResources
+        {
+            VkBuffer objectBuffer;
+            TaraskAllocation objectAllocation;
+            VkBuffer commandBuffer;
+            TaraskAllocation commandAllocation;
+            VkBuffer countBuffer;
+            TaraskAllocation countAllocation;
+            VkDescriptorSet descriptorSet;
+        };
+
+        void createDescriptorSetLayout();
+        void createPipelineLayout();
+        void createFrameResources(uint32_t frameCount);
+
+        TaraskDevice &m_taraskDevice;
+        uint32_t m_maxObjects;
+        float m_minPixelRadius = 1.0f;
+        glm::vec2 m_viewScale{1.0f, 1.0f};
+        glm::vec2 m_viewOffset{0.0f, 0.0f};
+
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        VkDescriptorPool m_descriptorPool;
+        VkPipelineLayout m_pipelineLayout;
+        std::unique_ptr<TaraskComputePipeline> m_cullPipeline;
+        std::vector<FrameResources> m_frames;
+
+        uint32_t m_frameIndex = 0;
+        uint32_t m_objectCount = 0;
+    };
+} // namespace tarask
@@ -0,0 +1,132 @@
+#include "tarask_deletion_queue.hpp"
+
+#include "tarask_device.hpp"
+#include "tarask_timeline.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace tarask
+{
+    TaraskDeletionQueue::TaraskDeletionQueue(TaraskDevice &device, TaraskTimeline &timeline)
+        : m_taraskDevice{device}, m_timeline{timeline}
+    {
+    }
+
+    TaraskDeletionQueue::~TaraskDeletionQueue() { flush(); }
+
+    void TaraskDeletionQueue::enqueue(uint64_t value, std::function<void()> destroy)
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        auto position = std::upper_bound(m_entries.begin(), m_entries.end(), value,
+                                         [](uint64_t value, const Entry &entry)
+                                         { return value < entry.value; });
+        m_entries.insert(position, Entry{value, std::move(destroy)});
+    }
+
+    void TaraskDeletionQueue::enqueue(std::function<void()> destroy)
+    {
+        enqueue(m_timeline.submittedValue(), std::move(destroy));
+    }
+
+    void TaraskDeletionQueue::destroyBuffer(VkBuffer buffer, const TaraskAllocation &allocation)
+    {
+        TaraskDevice &device = m_taraskDevice;
+        enqueue([&device, buffer, allocation = allocation]() mutable
+                { device.destroyBuffer(buffer, allocation); });
+    }
+
+    void TaraskDeletionQueue::destroyImage(VkImage image, const TaraskAllocation &allocation)
+    {
+        TaraskDevice &device = m_taraskDevice;
+        enqueue([&device, image, allocation = allocation]() mutable
+                { device.destroyImage(image, allocation); });
+    }
+
+    void TaraskDeletionQueue::destroyImageView(VkImageView imageView)
+    {
+        VkDevice device = m_taraskDevice.device();
+        enqueue([device, imageView]() { vkDestroyImageView(device, imageView, nullptr); });
+    }
+
+    void TaraskDeletionQueue::destroyFramebuffer(VkFramebuffer framebuffer)
+    {
+        VkDevice device = m_taraskDevice.device();
+        enqueue([device, framebuffer]() { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+    }
+
+    void TaraskDeletionQueue::destroyRenderPass(VkRenderPass renderPass)
+    {
+        VkDevice device = m_taraskDevice.device();
+        enqueue([device, renderPass]() { vkDestroyRenderPass(device, renderPass, nullptr); });
+    }
+
+    void TaraskDeletionQueue::destroyPipeline(VkPipeline pipeline)
+    {
+        VkDevice device = m_taraskDevice.device();
+        enqueue([device, pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); });
+    }
+
+    void TaraskDeletionQueue::destroyPipelineLayout(VkPipelineLayout pipelineLayout)
+    {
+        VkDevice device = m_taraskDevice.device();
+        enqueue([device, pipelineLayout]()
+                { vkDestroyPipelineLayout(device, pipelineLayout, nullptr); });
+    }
+
+    void TaraskDeletionQueue::destroyShaderModule(VkShaderModule shaderModule)
+    {
+        VkDevice device = m_taraskDevice.device();
+        enqueue([device, shaderModule]() { vkDestroyShaderModule(device, shaderModule, nullptr); });
+    }
+
+    void TaraskDeletionQueue::freeMemory(const TaraskAllocation &allocation)
+    {
+        TaraskDevice &device = m_taraskDevice;
+        enqueue([&device, allocation = allocation]() mutable
+                { device.allocator().free(allocation); });
+    }
+
+    void TaraskDeletionQueue::collect()
+    {
+        uint64_t completed = m_timeline.completedValue();
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            while (!m_entries.empty() && m_entries.front().value <= completed)
+            {
+                ready.push_back(std::move(m_entries.front().destroy));
+                m_entries.pop_front();
+            }
+        }
+        // outside the lock, a destroy may enqueue more work
+        for (auto &destroy : ready)
+        {
+            destroy();
+        }
+    }
+
+    void TaraskDeletionQueue::flush()
+    {
+        while (pendingCount() != 0)
+        {
+            // a value may be ahead of what was submitted, see TaraskSwapChain::recreate
+            m_timeline.wait(m_timeline.submittedValue());
+            std::deque<Entry> entries;
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                entries.swap(m_entries);
+            }
+            for (auto &entry : entries)
+            {
+                entry.destroy();
+            }
+        }
+    }
+
+    size_t TaraskDeletionQueue::pendingCount()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_entries.size();
+    }
+} // namespace tarask
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "tarask_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace tarask
+{
+    class TaraskDevice;
+    class TaraskTimeline;
+
+    // Destroys Vulkan objects once the graphics timeline shows that no submitted frame still
+    // uses them, so nothing has to wait for the device to go idle before releasing resources.
+    // Entries are keyed on a timeline value and run in value order from collect(). Anything
+    // may enqueue from any thread, destructors of GPU resources go through here instead of
+    // destroying on the spot.
+    class TaraskDeletionQueue
+    {
+    public:
+        TaraskDeletionQueue(TaraskDevice &device, TaraskTimeline &timeline);
+        // waits for the pending values and runs everything left
+        ~TaraskDeletionQueue();
+
+        TaraskDeletionQueue(const TaraskDeletionQueue &) = delete;
+        TaraskDeletionQueue &operator=(const TaraskDeletionQueue &) = delete;
+
+        // runs destroy once the timeline has reached value
+        void enqueue(uint64_t value, std::function<void()> destroy);
+        // keyed on the last submitted value, for objects recorded into a frame up to now
+        void enqueue(std::function<void()> destroy);
+
+        // the common objects, keyed on the last submitted value
+        void destroyBuffer(VkBuffer buffer, const TaraskAllocation &allocation);
+        void destroyImage(VkImage image, const TaraskAllocation &allocation);
+        void destroyImageView(VkImageView imageView);
+        void destroyFramebuffer(VkFramebuffer framebuffer);
+        void destroyRenderPass(VkRenderPass renderPass);
+        void destroyPipeline(VkPipeline pipeline);
+        void destroyPipelineLayout(VkPipelineLayout pipelineLayout);
+        void destroyShaderModule(VkShaderModule shaderModule);
+        // memory that was bound to an object destroyed elsewhere
+        void freeMemory(const TaraskAllocation &allocation);
+        // runs the entries whose value has completed, without blocking, once per frame
+        void collect();
+        // blocks until every entry has run
+        void flush();
+
+        size_t pendingCount();
+
+    private:
+        struct Entry
+        {
+            uint64_t value;
+            std::function<void()> destroy;
+        };
+
+        TaraskDevice &m_taraskDevice;
+        TaraskTimeline &m_timeline;
+        // sorted by value
+        std::deque<Entry> m_entries;
+        std::mutex m_mutex;
+    };
+} // namespace tarask
@@ -0,0 +1,212 @@
+#include "tarask_descriptors.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace tarask
+{
+    TaraskDescriptorSetLayout::Builder &
+    TaraskDescriptorSetLayout::Builder::addBinding(uint32_t binding,
+                                                   VkDescriptorType descriptorType,
+                                                   VkShaderStageFlags stageFlags, uint32_t count,
+                                                   VkDescriptorBindingFlags bindingFlags)
+    {
+        if (m_bindings.count(binding) != 0)
+        {
+            throw std::runtime_error("TaraskDescriptorSetLayout: binding already in use.");
+        }
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding = binding;
+        layoutBinding.descriptorType = descriptorType;
+        layoutBinding.descriptorCount = count;
+        layoutBinding.stageFlags = stageFlags;
+        m_bindings[binding] = layoutBinding;
+        if (bindingFlags != 0)
+        {
+            m_bindingFlags[binding] = bindingFlags;
+        }
+        return *this;
+    }
+
+    TaraskDescriptorSetLayout::Builder &
+    TaraskDescriptorSetLayout::Builder::setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags)
+    {
+        m_layoutFlags = flags;
+        return *this;
+    }
+
+    std::unique_ptr<TaraskDescriptorSetLayout> TaraskDescriptorSetLayout::Builder::build() const
+    {
+        return std::make_unique<TaraskDescriptorSetLayout>(m_taraskDevice, m_bindings,
+                                                           m_bindingFlags, m_layoutFlags);
+    }
+
+    TaraskDescriptorSetLayout::TaraskDescriptorSetLayout(
+        TaraskDevice &device, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags,
+        VkDescriptorSetLayoutCreateFlags layoutFlags)
+        : m_taraskDevice{device}, m_bindings{std::move(bindings)}
+    {
+        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings;
+        std::vector<VkDescriptorBindingFlags> setBindingFlags;
+        setLayoutBindings.reserve(m_bindings.size());
+        setBindingFlags.reserve(m_bindings.size());
+        for (const auto &entry : m_bindings)
+        {
+            setLayoutBindings.push_back(entry.second);
+            auto flags = bindingFlags.find(entry.first);
+            setBindingFlags.push_back(flags == bindingFlags.end() ? 0 : flags->second);
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.flags = layoutFlags;
+        layoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+        layoutInfo.pBindings = setLayoutBindings.data();
+
+        // one entry per binding, in the same order as pBindings
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+        flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        flagsInfo.bindingCount = static_cast<uint32_t>(setBindingFlags.size());
+        flagsInfo.pBindingFlags = setBindingFlags.data();
+        if (!bindingFlags.empty())
+        {
+            layoutInfo.pNext = &flagsInfo;
+        }
+        if (vkCreateDescriptorSetLayout(m_taraskDevice.device(), &layoutInfo, nullptr,
+                                        &m_descriptorSetLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error(
+                "TaraskDescriptorSetLayout: failed to create descriptor set layout.");
+        }
+    }
+
+    TaraskDescriptorSetLayout::~TaraskDescriptorSetLayout()
+    {
+        VkDevice device = m_taraskDevice.device();
+        m_taraskDevice.deletionQueue().enqueue(
+            [device, setLayout = m_descriptorSetLayout]()
+            { vkDestroyDescriptorSetLayout(device, setLayout, nullptr); });
+    }
+
+    TaraskDescriptorPool::Builder &
+    TaraskDescriptorPool::Builder::addPoolSize(VkDescriptorType descriptorType, uint32_t count)
+    {
+        m_poolSizes.push_back({descriptorType, count});
+        return *this;
+    }
+
+    TaraskDescriptorPool::Builder &
+    TaraskDescriptorPool::Builder::setPoolFlags(VkDescriptorPoolCreateFlags flags)
+    {
+        m_poolFlags = flags;
+        return *this;
+    }
+
+    TaraskDescriptorPool::Builder &TaraskDescriptorPool::Builder::setMaxSets(uint32_t count)
+    {
+        m_maxSets = count;
+        return *this;
+    }
+
+    std::unique_ptr<TaraskDescriptorPool> TaraskDescriptorPool::Builder::build() const
+    {
+        return std::make_unique<TaraskDescriptorPool>(m_taraskDevice, m_maxSets, m_poolFlags,
+                                                      m_poolSizes);
+    }
+
+    TaraskDescriptorPool::TaraskDescriptorPool(TaraskDevice &device, uint32_t maxSets,
+                                               VkDescriptorPoolCreateFlags poolFlags,
+                                               const std::vector<VkDescriptorPoolSize> &poolSizes)
+        : m_taraskDevice{device}
+    {
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = maxSets;
+        poolInfo.flags = poolFlags;
+        if (vkCreateDescriptorPool(m_taraskDevice.device(), &poolInfo, nullptr,
+                                   &m_descriptorPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskDescriptorPool: failed to create descriptor pool.");
+        }
+    }
+
+    TaraskDescriptorPool::~TaraskDescriptorPool()
+    {
+        VkDevice device = m_taraskDevice.device();
+        m_taraskDevice.deletionQueue().enqueue(
+            [device, descriptorPool = m_descriptorPool]()
+            { vkDestroyDescriptorPool(device, descriptorPool, nullptr); });
+    }
+
+    bool TaraskDescriptorPool::allocateDescriptor(VkDescriptorSetLayout descriptorSetLayout,
+                                                  VkDescriptorSet &descriptor) const
+    {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_descriptorPool;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+        allocInfo.descriptorSetCount = 1;
+        return vkAllocateDescriptorSets(m_taraskDevice.device(), &allocInfo, &descriptor) ==
+               VK_SUCCESS;
+    }
+
+    void TaraskDescriptorPool::resetPool()
+    {
+        vkResetDescriptorPool(m_taraskDevice.device(), m_descriptorPool, 0);
+    }
+
+    TaraskDescriptorWriter::TaraskDescriptorWriter(TaraskDescriptorSetLayout &setLayout,
+                                                   TaraskDescriptorPool &pool)
+        : m_setLayout{setLayout}, m_pool{pool}
+    {
+    }
+
+    TaraskDescriptorWriter &
+    TaraskDescriptorWriter::writeBuffer(uint32_t binding, const VkDescriptorBufferInfo *bufferInfo)
+    {
+        auto found = m_setLayout.m_bindings.find(binding);
+        if (found == m_setLayout.m_bindings.end())
+        {
+            throw std::runtime_error("TaraskDescriptorWriter: layout has no such binding.");
+        }
+        const auto &bindingDescription = found->second;
+        if (bindingDescription.descriptorCount != 1)
+        {
+            throw std::runtime_error(
+                "TaraskDescriptorWriter: binding expects an array of descriptors.");
+        }
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.pBufferInfo = bufferInfo;
+        write.descriptorCount = 1;
+        m_writes.push_back(write);
+        return *this;
+    }
+
+    bool TaraskDescriptorWriter::build(VkDescriptorSet &set)
+    {
+        if (!m_pool.allocateDescriptor(m_setLayout.getDescriptorSetLayout(), set))
+        {
+            return false;
+        }
+        overwrite(set);
+        return true;
+    }
+
+    void TaraskDescriptorWriter::overwrite(VkDescriptorSet &set)
+    {
+        for (auto &write : m_writes)
+        {
+            write.dstSet = set;
+        }
+        vkUpdateDescriptorSets(m_pool.m_taraskDevice.device(),
+                               static_cast<uint32_t>(m_writes.size()), m_writes.data(), 0,
+                               nullptr);
+    }
+} // namespace tarask
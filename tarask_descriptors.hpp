@@ -0,0 +1,118 @@
+#pragma once
+
+#include "tarask_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace tarask
+{
+    // Which descriptors a set holds, built binding by binding.
+    class TaraskDescriptorSetLayout
+    {
+    public:
+        class Builder
+        {
+        public:
+            Builder(TaraskDevice &device) : m_taraskDevice{device} {}
+
+            Builder &addBinding(uint32_t binding, VkDescriptorType descriptorType,
+                                VkShaderStageFlags stageFlags, uint32_t count = 1,
+                                VkDescriptorBindingFlags bindingFlags = 0);
+            Builder &setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
+            std::unique_ptr<TaraskDescriptorSetLayout> build() const;
+
+        private:
+            TaraskDevice &m_taraskDevice;
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> m_bindings;
+            // only chained in when some binding has flags, they need descriptor indexing
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> m_bindingFlags;
+            VkDescriptorSetLayoutCreateFlags m_layoutFlags = 0;
+        };
+
+        TaraskDescriptorSetLayout(
+            TaraskDevice &device,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {},
+            VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
+        ~TaraskDescriptorSetLayout();
+
+        TaraskDescriptorSetLayout(const TaraskDescriptorSetLayout &) = delete;
+        TaraskDescriptorSetLayout &operator=(const TaraskDescriptorSetLayout &) = delete;
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return m_descriptorSetLayout; }
+
+    private:
+        friend class TaraskDescriptorWriter;
+
+        TaraskDevice &m_taraskDevice;
+        VkDescriptorSetLayout m_descriptorSetLayout;
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> m_bindings;
+    };
+
+    // Sets allocated from a pool live as long as it, or until resetPool(). The pool itself is
+    // released through the deletion queue, so sets bound by frames in flight stay valid.
+    class TaraskDescriptorPool
+    {
+    public:
+        class Builder
+        {
+        public:
+            Builder(TaraskDevice &device) : m_taraskDevice{device} {}
+
+            Builder &addPoolSize(VkDescriptorType descriptorType, uint32_t count);
+            Builder &setPoolFlags(VkDescriptorPoolCreateFlags flags);
+            Builder &setMaxSets(uint32_t count);
+            std::unique_ptr<TaraskDescriptorPool> build() const;
+
+        private:
+            TaraskDevice &m_taraskDevice;
+            std::vector<VkDescriptorPoolSize> m_poolSizes;
+            uint32_t m_maxSets = 1000;
+            VkDescriptorPoolCreateFlags m_poolFlags = 0;
+        };
+
+        TaraskDescriptorPool(TaraskDevice &device, uint32_t maxSets,
+                             VkDescriptorPoolCreateFlags poolFlags,
+                             const std::vector<VkDescriptorPoolSize> &poolSizes);
+        ~TaraskDescriptorPool();
+
+        TaraskDescriptorPool(const TaraskDescriptorPool &) = delete;
+        TaraskDescriptorPool &operator=(const TaraskDescriptorPool &) = delete;
+
+        // false once the pool is exhausted
+        bool allocateDescriptor(VkDescriptorSetLayout descriptorSetLayout,
+                                VkDescriptorSet &descriptor) const;
+        // No set from the pool may still be used by a pending frame.
+        void resetPool();
+
+    private:
+        friend class TaraskDescriptorWriter;
+
+        TaraskDevice &m_taraskDevice;
+        VkDescriptorPool m_descriptorPool;
+    };
+
+    // Collects the writes for one set, checked against its layout, then allocates and
+    // updates it in one go.
+    class TaraskDescriptorWriter
+    {
+    public:
+        TaraskDescriptorWriter(TaraskDescriptorSetLayout &setLayout, TaraskDescriptorPool &pool);
+
+        // bufferInfo must stay alive until build() or overwrite()
+        TaraskDescriptorWriter &writeBuffer(uint32_t binding,
+                                            const VkDescriptorBufferInfo *bufferInfo);
+
+        bool build(VkDescriptorSet &set);
+        void overwrite(VkDescriptorSet &set);
+
+    private:
+        TaraskDescriptorSetLayout &m_setLayout;
+        TaraskDescriptorPool &m_pool;
+        std::vector<VkWriteDescriptorSet> m_writes;
+    };
+} // namespace tarask
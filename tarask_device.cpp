@@ -4,6 +4,7 @@
 // std headers
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <unordered_set>
 
@@ -50,7 +51,7 @@ namespace tarask
     }
 
     // class member functions
-    TaraskDevice::TaraskDevice(TaraskWindow &window) : window{window}
+    TaraskDevice::TaraskDevice(TaraskWindow *window) : window{window}
     {
         createInstance();
         setupDebugMessenger();
@@ -58,10 +59,23 @@ namespace tarask
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        graphicsTimeline_ = std::make_unique<TaraskTimeline>(*this);
+        allocator_ = std::make_unique<TaraskAllocator>(*this);
+        deletionQueue_ = std::make_unique<TaraskDeletionQueue>(*this, *graphicsTimeline_);
+        uploader_ = std::make_unique<TaraskUploader>(*this);
+        pipelineCache_ = std::make_unique<TaraskPipelineCache>(*this, pipelineCachePath);
     }
 
     TaraskDevice::~TaraskDevice()
     {
+        // presentation has no timeline value, the deletion queue only sees the submits
+        vkDeviceWaitIdle(device_);
+        // deferred destructions may still wait on the uploader
+        deletionQueue_.reset();
+        pipelineCache_.reset();
+        uploader_.reset();
+        allocator_.reset();
+        graphicsTimeline_.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -70,7 +84,10 @@ namespace tarask
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -156,6 +173,10 @@ namespace tarask
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        if (indices.transferFamilyHasValue)
+        {
+            uniqueQueueFamilies.insert(indices.transferFamily);
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -168,8 +189,18 @@ namespace tarask
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // without these, indirect draws fall back to one call per draw (see TaraskDrawList)
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        // only TaraskGpuProfiler uses them, for its optional invocation counts. The counted
+        // draws run in secondary command buffers, which needs inheritedQueries.
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        deviceFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -177,9 +208,100 @@ namespace tarask
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+        // optional extensions are enabled on top of the required ones when available
+        std::vector<const char *> enabledExtensions;
+        if (!isHeadless())
+        {
+            enabledExtensions = deviceExtensions;
+        }
+        if (isDeviceExtensionAvailable(physicalDevice,
+                                       VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME))
+        {
+            enabledExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+            pipelineCreationFeedbackEnabled_ = true;
+        }
+        bool drawIndirectCountAvailable =
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (drawIndirectCountAvailable)
+        {
+            enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+
+        // the timeline and descriptor indexing features have to be queried and enabled through
+        // the features2 chain
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+        timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        VkPhysicalDeviceDescriptorIndexingFeatures enabledIndexingFeatures{};
+        enabledIndexingFeatures.sType =
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        bool timelineAvailable =
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        // descriptor indexing depends on maintenance3
+        bool indexingAvailable =
+            isDeviceExtensionAvailable(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+            isDeviceExtensionAvailable(physicalDevice, VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(
+            instance, "vkGetPhysicalDeviceFeatures2KHR");
+        auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(
+            instance, "vkGetPhysicalDeviceProperties2KHR");
+        if (physicalDeviceProperties2Enabled_ && getFeatures2 != nullptr &&
+            (timelineAvailable || indexingAvailable))
+        {
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            timelineFeatures.pNext = &indexingFeatures;
+            features2.pNext = &timelineFeatures;
+            getFeatures2(physicalDevice, &features2);
+            timelineFeatures.pNext = nullptr;
+            timelineFeatures.timelineSemaphore =
+                timelineAvailable ? timelineFeatures.timelineSemaphore : VK_FALSE;
+
+            const void *next = nullptr;
+            if (timelineFeatures.timelineSemaphore)
+            {
+                enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+                next = &timelineFeatures;
+            }
+            // TaraskBindlessTable needs all of these, partial support is treated as none
+            if (indexingAvailable && getProperties2 != nullptr &&
+                indexingFeatures.runtimeDescriptorArray &&
+                indexingFeatures.descriptorBindingPartiallyBound &&
+                indexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+                indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind &&
+                indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+                indexingFeatures.shaderStorageBufferArrayNonUniformIndexing &&
+                indexingFeatures.shaderSampledImageArrayNonUniformIndexing)
+            {
+                enabledExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+                enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+                enabledIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+                enabledIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+                enabledIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+                enabledIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+                enabledIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+                enabledIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+                enabledIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+                enabledIndexingFeatures.pNext = const_cast<void *>(next);
+                next = &enabledIndexingFeatures;
+
+                // update after bind descriptors have their own, usually much larger, limits
+                descriptorIndexingProperties_.sType =
+                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+                VkPhysicalDeviceProperties2 properties2{};
+                properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                properties2.pNext = &descriptorIndexingProperties_;
+                getProperties2(physicalDevice, &properties2);
+                descriptorIndexingProperties_.pNext = nullptr;
+                descriptorIndexingEnabled_ = true;
+            }
+            createInfo.pNext = next;
+        }
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -197,9 +319,34 @@ namespace tarask
         {
             throw std::runtime_error("failed to create logical device!");
         }
+        enabledFeatures_ = deviceFeatures;
+        if (drawIndirectCountAvailable)
+        {
+            cmdDrawIndexedIndirectCount_ = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(
+                device_, "vkCmdDrawIndexedIndirectCountKHR");
+        }
+        if (timelineFeatures.timelineSemaphore)
+        {
+            waitSemaphores_ = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(device_, "vkWaitSemaphoresKHR");
+            getSemaphoreCounterValue_ = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(
+                device_, "vkGetSemaphoreCounterValueKHR");
+        }
 
+        graphicsFamily_ = indices.graphicsFamily;
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        if (indices.transferFamilyHasValue)
+        {
+            transferFamily_ = indices.transferFamily;
+            vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+            std::cout << "dedicated transfer queue family: " << transferFamily_ << std::endl;
+        }
+        else
+        {
+            transferFamily_ = indices.graphicsFamily;
+            transferQueue_ = graphicsQueue_;
+        }
     }
 
     void TaraskDevice::createCommandPool()
@@ -218,16 +365,23 @@ namespace tarask
         }
     }
 
-    void TaraskDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void TaraskDevice::createSurface()
+    {
+        if (!isHeadless())
+        {
+            window->createWindowSurface(instance, &surface_);
+        }
+    }
 
     bool TaraskDevice::isDeviceSuitable(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
-        bool extensionsSupported = checkDeviceExtensionSupport(device);
+        // headless devices never present, so they need neither the swap chain nor a surface
+        bool extensionsSupported = isHeadless() || checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported)
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless())
         {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate =
@@ -300,17 +454,34 @@ namespace tarask
 
     std::vector<const char *> TaraskDevice::getRequiredExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char *> extensions;
+        if (!isHeadless())
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char **glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers)
         {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
 
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> available(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, available.data());
+        for (const auto &extension : available)
+        {
+            if (strcmp(extension.extensionName,
+                       VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+            {
+                extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                physicalDeviceProperties2Enabled_ = true;
+            }
+        }
+
         return extensions;
     }
 
@@ -360,6 +531,26 @@ namespace tarask
         return requiredExtensions.empty();
     }
 
+    bool TaraskDevice::isDeviceExtensionAvailable(VkPhysicalDevice device,
+                                                  const char *extensionName)
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
+                                             availableExtensions.data());
+
+        for (const auto &extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     QueueFamilyIndices TaraskDevice::findQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -379,7 +570,16 @@ namespace tarask
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (isHeadless())
+            {
+                // nothing is presented, the graphics family stands in for the present one
+                presentSupport =
+                    (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+            }
+            else
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport)
             {
                 indices.presentFamily = i;
@@ -393,6 +593,22 @@ namespace tarask
             i++;
         }
 
+        // prefer a pure transfer family over an async compute one
+        for (uint32_t family = 0; family < queueFamilyCount; family++)
+        {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) ||
+                (flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                continue;
+            }
+            if (!indices.transferFamilyHasValue || !(flags & VK_QUEUE_COMPUTE_BIT))
+            {
+                indices.transferFamily = family;
+                indices.transferFamilyHasValue = true;
+            }
+        }
+
         return indices;
     }
 
@@ -463,7 +679,8 @@ namespace tarask
 
     void TaraskDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
                                     VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                                    VkDeviceMemory &bufferMemory)
+                                    TaraskAllocation &bufferAllocation,
+                                    AllocationStrategy strategy)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -471,6 +688,17 @@ namespace tarask
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+        uint32_t queueFamilyIndices[2];
+        if (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+        {
+            bufferInfo.sharingMode = resourceSharingMode(queueFamilyIndices);
+        }
+        if (bufferInfo.sharingMode == VK_SHARING_MODE_CONCURRENT)
+        {
+            bufferInfo.queueFamilyIndexCount = 2;
+            bufferInfo.pQueueFamilyIndices = queueFamilyIndices;
+        }
+
         if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create vertex buffer!");
@@ -479,17 +707,20 @@ namespace tarask
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferAllocation =
+            allocator_->allocate(memRequirements, properties, ResourceKind::Linear, strategy);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+        if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory,
+                               bufferAllocation.offset) != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+            throw std::runtime_error("failed to bind buffer memory!");
         }
+    }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    void TaraskDevice::destroyBuffer(VkBuffer buffer, TaraskAllocation &bufferAllocation)
+    {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator_->free(bufferAllocation);
     }
 
     VkCommandBuffer TaraskDevice::beginSingleTimeCommands()
@@ -520,53 +751,49 @@ namespace tarask
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // wait on this submission only instead of idling the whole graphics queue
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create single time command fence!");
+        }
+
+        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
 
+        vkDestroyFence(device_, fence, nullptr);
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
 
-    void TaraskDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+    UploadTicket TaraskDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
+                                          VkDeviceSize size)
     {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0; // Optional
-        copyRegion.dstOffset = 0; // Optional
-        copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-        endSingleTimeCommands(commandBuffer);
+        return uploader_->copyBuffer(srcBuffer, dstBuffer, size);
     }
 
-    void TaraskDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
-                                         uint32_t height, uint32_t layerCount)
+    UploadTicket TaraskDevice::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
+                                                 uint32_t height, uint32_t layerCount)
     {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = layerCount;
-
-        region.imageOffset = {0, 0, 0};
-        region.imageExtent = {width, height, 1};
-
-        vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                               1, &region);
-        endSingleTimeCommands(commandBuffer);
+        return uploader_->copyBufferToImage(buffer, image, width, height, layerCount);
     }
 
     void TaraskDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo,
                                            VkMemoryPropertyFlags properties, VkImage &image,
-                                           VkDeviceMemory &imageMemory)
+                                           TaraskAllocation &imageAllocation)
     {
-        if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
+        VkImageCreateInfo createInfo = imageInfo;
+        uint32_t queueFamilyIndices[2];
+        if ((imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) &&
+            resourceSharingMode(queueFamilyIndices) == VK_SHARING_MODE_CONCURRENT)
+        {
+            createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilyIndices;
+        }
+
+        if (vkCreateImage(device_, &createInfo, nullptr, &image) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create image!");
         }
@@ -574,20 +801,34 @@ namespace tarask
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        ResourceKind kind = imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? ResourceKind::Linear
+                                                                       : ResourceKind::Optimal;
+        imageAllocation = allocator_->allocate(memRequirements, properties, kind);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
+        if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) !=
+            VK_SUCCESS)
         {
-            throw std::runtime_error("failed to allocate image memory!");
+            throw std::runtime_error("failed to bind image memory!");
         }
+    }
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+    VkSharingMode TaraskDevice::resourceSharingMode(uint32_t queueFamilyIndices[2])
+    {
+        // resources written by the transfer queue and read by the graphics queue are shared
+        // concurrently rather than going through queue family ownership transfers
+        if (!hasDedicatedTransferQueue())
         {
-            throw std::runtime_error("failed to bind image memory!");
+            return VK_SHARING_MODE_EXCLUSIVE;
         }
+        queueFamilyIndices[0] = graphicsFamily_;
+        queueFamilyIndices[1] = transferFamily_;
+        return VK_SHARING_MODE_CONCURRENT;
+    }
+
+    void TaraskDevice::destroyImage(VkImage image, TaraskAllocation &imageAllocation)
+    {
+        vkDestroyImage(device_, image, nullptr);
+        allocator_->free(imageAllocation);
     }
 
 } // namespace tarask
\ No newline at end of file
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "tarask_allocator.hpp"
+#include "tarask_deletion_queue.hpp"
+#include "tarask_pipeline_cache.hpp"
+#include "tarask_timeline.hpp"
+#include "tarask_uploader.hpp"
 #include "tarask_window.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,8 +26,11 @@ namespace tarask
     {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // a family with transfer but without graphics support, usually backed by DMA engines
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -34,7 +43,10 @@ namespace tarask
         const bool enableValidationLayers = true;
 #endif
 
-        TaraskDevice(TaraskWindow &window);
+        // A null window creates a headless device: no surface, no swap chain extension and
+        // no present queue, for rendering into a TaraskOffscreenTarget.
+        TaraskDevice(TaraskWindow *window);
+        TaraskDevice(TaraskWindow &window) : TaraskDevice(&window) {}
         ~TaraskDevice();
 
         // Not copyable or movable
@@ -45,9 +57,62 @@ namespace tarask
 
         VkCommandPool getCommandPool() { return commandPool; }
         VkDevice device() { return device_; }
+        VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+        TaraskAllocator &allocator() { return *allocator_; }
         VkSurfaceKHR surface() { return surface_; }
+        bool isHeadless() { return window == nullptr; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // falls back to the graphics queue when there is no dedicated transfer family
+        VkQueue transferQueue() { return transferQueue_; }
+        uint32_t transferQueueFamily() { return transferFamily_; }
+        bool hasDedicatedTransferQueue() { return transferQueue_ != graphicsQueue_; }
+        TaraskUploader &uploader() { return *uploader_; }
+        TaraskPipelineCache &pipelineCache() { return *pipelineCache_; }
+        // every graphics queue submission goes through it, frame pacing keys off its values
+        TaraskTimeline &graphicsTimeline() { return *graphicsTimeline_; }
+        // releases objects once the graphics timeline is past the frames that used them
+        TaraskDeletionQueue &deletionQueue() { return *deletionQueue_; }
+        bool supportsPipelineCreationFeedback() { return pipelineCreationFeedbackEnabled_; }
+        // optional indirect drawing features, enabled in createLogicalDevice when supported
+        bool supportsMultiDrawIndirect() { return enabledFeatures_.multiDrawIndirect; }
+        bool supportsDrawIndirectFirstInstance()
+        {
+            return enabledFeatures_.drawIndirectFirstInstance;
+        }
+        bool supportsPipelineStatistics() { return enabledFeatures_.pipelineStatisticsQuery; }
+        // queries left active while secondary command buffers execute
+        bool supportsInheritedQueries() { return enabledFeatures_.inheritedQueries; }
+        // VK_KHR_draw_indirect_count, lets the GPU decide how many indirect draws to run
+        bool supportsDrawIndirectCount() { return cmdDrawIndexedIndirectCount_ != nullptr; }
+        void cmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                         VkDeviceSize offset, VkBuffer countBuffer,
+                                         VkDeviceSize countBufferOffset, uint32_t maxDrawCount,
+                                         uint32_t stride)
+        {
+            cmdDrawIndexedIndirectCount_(commandBuffer, buffer, offset, countBuffer,
+                                         countBufferOffset, maxDrawCount, stride);
+        }
+
+        // VK_EXT_descriptor_indexing with update after bind, nonuniform indexing and partially
+        // bound arrays of storage buffers and sampled images, what TaraskBindlessTable uses
+        bool supportsDescriptorIndexing() { return descriptorIndexingEnabled_; }
+        // only filled in when supportsDescriptorIndexing()
+        const VkPhysicalDeviceDescriptorIndexingProperties &descriptorIndexingProperties()
+        {
+            return descriptorIndexingProperties_;
+        }
+
+        // VK_KHR_timeline_semaphore, TaraskTimeline falls back to fences without it
+        bool supportsTimelineSemaphores() { return waitSemaphores_ != nullptr; }
+        VkResult waitSemaphores(const VkSemaphoreWaitInfo &waitInfo, uint64_t timeout)
+        {
+            return waitSemaphores_(device_, &waitInfo, timeout);
+        }
+        VkResult getSemaphoreCounterValue(VkSemaphore semaphore, uint64_t *value)
+        {
+            return getSemaphoreCounterValue_(device_, semaphore, value);
+        }
 
         SwapChainSupportDetails getSwapChainSupport()
         {
@@ -61,16 +126,21 @@ namespace tarask
         // Buffer Helper Functions
         void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
                           VkMemoryPropertyFlags properties, VkBuffer &buffer,
-                          VkDeviceMemory &bufferMemory);
+                          TaraskAllocation &bufferAllocation,
+                          AllocationStrategy strategy = AllocationStrategy::FreeList);
+        void destroyBuffer(VkBuffer buffer, TaraskAllocation &bufferAllocation);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-        void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height,
-                               uint32_t layerCount);
+        // Both copies are batched on the transfer queue, wait on the ticket before reusing
+        // the source or reading the destination.
+        UploadTicket copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        UploadTicket copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
+                                       uint32_t height, uint32_t layerCount);
 
         void createImageWithInfo(const VkImageCreateInfo &imageInfo,
                                  VkMemoryPropertyFlags properties, VkImage &image,
-                                 VkDeviceMemory &imageMemory);
+                                 TaraskAllocation &imageAllocation);
+        void destroyImage(VkImage image, TaraskAllocation &imageAllocation);
 
         VkPhysicalDeviceProperties properties;
 
@@ -90,21 +160,42 @@ namespace tarask
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char *extensionName);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+        VkSharingMode resourceSharingMode(uint32_t queueFamilyIndices[2]);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        TaraskWindow &window;
+        TaraskWindow *window;
         VkCommandPool commandPool;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        uint32_t graphicsFamily_;
+        uint32_t transferFamily_;
+        std::unique_ptr<TaraskAllocator> allocator_;
+        std::unique_ptr<TaraskUploader> uploader_;
+        std::unique_ptr<TaraskPipelineCache> pipelineCache_;
+        std::unique_ptr<TaraskTimeline> graphicsTimeline_;
+        std::unique_ptr<TaraskDeletionQueue> deletionQueue_;
+        bool pipelineCreationFeedbackEnabled_ = false;
+        VkPhysicalDeviceFeatures enabledFeatures_{};
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount_ = nullptr;
+        PFN_vkWaitSemaphores waitSemaphores_ = nullptr;
+        PFN_vkGetSemaphoreCounterValue getSemaphoreCounterValue_ = nullptr;
+        bool descriptorIndexingEnabled_ = false;
+        VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties_{};
+        // VK_KHR_get_physical_device_properties2, needed to query the timeline and descriptor
+        // indexing features
+        bool physicalDeviceProperties2Enabled_ = false;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        const char *pipelineCachePath = "pipeline_cache.bin";
     };
 
 } // namespace tarask
\ No newline at end of file
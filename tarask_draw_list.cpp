@@ -0,0 +1,80 @@
+#include "tarask_draw_list.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskDrawList::TaraskDrawList(TaraskDevice &device, uint32_t capacity)
+        : m_taraskDevice{device}, m_capacity{capacity}
+    {
+        m_taraskDevice.createBuffer(sizeof(VkDrawIndexedIndirectCommand) * VkDeviceSize{capacity},
+                                    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                    m_buffer, m_allocation);
+        if (m_allocation.mappedData == nullptr)
+        {
+            throw std::runtime_error("TaraskDrawList: indirect memory is not mapped.");
+        }
+        m_commands = static_cast<VkDrawIndexedIndirectCommand *>(m_allocation.mappedData);
+    }
+
+    TaraskDrawList::~TaraskDrawList()
+    {
+        m_taraskDevice.deletionQueue().destroyBuffer(m_buffer, m_allocation);
+    }
+
+    void TaraskDrawList::addDraw(const TaraskMesh &mesh, uint32_t instanceCount,
+                                 uint32_t firstInstance)
+    {
+        if (m_drawCount == m_capacity)
+        {
+            throw std::runtime_error("TaraskDrawList: too many draws.");
+        }
+        VkDrawIndexedIndirectCommand &command = m_commands[m_drawCount++];
+        command.indexCount = mesh.indexCount;
+        command.instanceCount = instanceCount;
+        command.firstIndex = mesh.firstIndex;
+        command.vertexOffset = mesh.vertexOffset;
+        command.firstInstance = firstInstance;
+    }
+
+    void TaraskDrawList::record(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)
+    {
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        first = std::min(first, m_drawCount);
+        const uint32_t end = first + std::min(count, m_drawCount - first);
+
+        // a non zero firstInstance in an indirect command needs drawIndirectFirstInstance,
+        // direct draws take it everywhere
+        if (!m_taraskDevice.supportsDrawIndirectFirstInstance())
+        {
+            for (uint32_t i = first; i < end; i++)
+            {
+                const auto &command = m_commands[i];
+                vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount,
+                                 command.firstIndex, command.vertexOffset, command.firstInstance);
+            }
+            return;
+        }
+
+        if (!m_taraskDevice.supportsMultiDrawIndirect())
+        {
+            for (uint32_t i = first; i < end; i++)
+            {
+                vkCmdDrawIndexedIndirect(commandBuffer, m_buffer, VkDeviceSize{i} * stride, 1,
+                                         stride);
+            }
+            return;
+        }
+
+        uint32_t maxDrawCount = m_taraskDevice.properties.limits.maxDrawIndirectCount;
+        for (uint32_t batch = first; batch < end; batch += maxDrawCount)
+        {
+            uint32_t batchCount = std::min(maxDrawCount, end - batch);
+            vkCmdDrawIndexedIndirect(commandBuffer, m_buffer, VkDeviceSize{batch} * stride,
+                                     batchCount, stride);
+        }
+    }
+} // namespace tarask
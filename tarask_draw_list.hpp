@@ -0,0 +1,43 @@
+#pragma once
+
+#include "tarask_device.hpp"
+#include "tarask_geometry_arena.hpp"
+
+// std lib headers
+#include <cstdint>
+
+namespace tarask
+{
+    // Host visible VkDrawIndexedIndirectCommand array for meshes of one TaraskGeometryArena.
+    // The CPU rewrites it every frame, so keep one per frame in flight.
+    class TaraskDrawList
+    {
+    public:
+        TaraskDrawList(TaraskDevice &device, uint32_t capacity);
+        ~TaraskDrawList();
+
+        TaraskDrawList(const TaraskDrawList &) = delete;
+        TaraskDrawList &operator=(const TaraskDrawList &) = delete;
+
+        void clear() { m_drawCount = 0; }
+        void addDraw(const TaraskMesh &mesh, uint32_t instanceCount = 1,
+                     uint32_t firstInstance = 0);
+        // Issues the draws in [first, first + count) of those added since clear(), every one by
+        // default. The arena must already be bound. Disjoint ranges may be recorded into
+        // different command buffers from different threads.
+        void record(VkCommandBuffer commandBuffer, uint32_t first = 0,
+                    uint32_t count = UINT32_MAX);
+
+        VkBuffer buffer() { return m_buffer; }
+        uint32_t drawCount() { return m_drawCount; }
+        uint32_t capacity() { return m_capacity; }
+
+    private:
+        TaraskDevice &m_taraskDevice;
+        VkBuffer m_buffer;
+        TaraskAllocation m_allocation;
+        VkDrawIndexedIndirectCommand *m_commands;
+        uint32_t m_capacity;
+        uint32_t m_drawCount = 0;
+    };
+} // namespace tarask
@@ -0,0 +1,43 @@
+#include "tarask_frame_limiter.hpp"
+
+#include <thread>
+
+namespace tarask
+{
+    TaraskFrameLimiter::TaraskFrameLimiter(double maxFps) { setMaxFps(maxFps); }
+
+    void TaraskFrameLimiter::setMaxFps(double maxFps)
+    {
+        m_period = maxFps > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>(1.0 / maxFps))
+                                : Clock::duration{0};
+        m_nextFrame = Clock::time_point{};
+    }
+
+    void TaraskFrameLimiter::wait()
+    {
+        if (!isEnabled())
+        {
+            return;
+        }
+
+        auto now = Clock::now();
+        // first frame, or more than a whole period late: start over instead of letting a
+        // burst of frames catch up
+        if (m_nextFrame == Clock::time_point{} || now - m_nextFrame > m_period)
+        {
+            m_nextFrame = now + m_period;
+            return;
+        }
+
+        if (m_nextFrame - now > SPIN_THRESHOLD)
+        {
+            std::this_thread::sleep_for(m_nextFrame - now - SPIN_THRESHOLD);
+        }
+        while (Clock::now() < m_nextFrame)
+        {
+            std::this_thread::yield();
+        }
+        m_nextFrame += m_period;
+    }
+} // namespace tarask
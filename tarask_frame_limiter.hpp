@@ -0,0 +1,31 @@
+#pragma once
+
+// std lib headers
+#include <chrono>
+
+namespace tarask
+{
+    // Holds the frame loop to a target rate on the CPU. Deadlines advance by a fixed period
+    // rather than from the time wait() returns, so the average rate stays exact. The bulk of
+    // the wait is a sleep and the last stretch, where the OS scheduler is too coarse, a spin.
+    class TaraskFrameLimiter
+    {
+    public:
+        // 0 disables the limiter
+        explicit TaraskFrameLimiter(double maxFps = 0.0);
+
+        void setMaxFps(double maxFps);
+        bool isEnabled() const { return m_period.count() > 0; }
+        // Call once per frame, returns right away when disabled.
+        void wait();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        // the remaining time below which wait() spins instead of sleeping
+        static constexpr std::chrono::microseconds SPIN_THRESHOLD{1500};
+
+        Clock::duration m_period{0};
+        Clock::time_point m_nextFrame{};
+    };
+} // namespace tarask
@@ -0,0 +1,96 @@
+#include "tarask_frame_ring.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tarask
+{
+    namespace
+    {
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // the region starts must suit either kind of binding
+        VkDeviceSize regionAlignment(const VkPhysicalDeviceLimits &limits)
+        {
+            return std::max<VkDeviceSize>({limits.minUniformBufferOffsetAlignment,
+                                           limits.minStorageBufferOffsetAlignment, 16});
+        }
+    } // namespace
+
+    TaraskFrameRing::TaraskFrameRing(TaraskDevice &device, VkDeviceSize bytesPerFrame,
+                                     uint32_t frameCount, VkBufferUsageFlags usage)
+        : m_taraskDevice{device},
+          m_regionSize{alignUp(bytesPerFrame, regionAlignment(device.properties.limits))},
+          m_frameCount{frameCount}
+    {
+        if (m_regionSize * frameCount > UINT32_MAX)
+        {
+            // dynamic offsets are 32 bit
+            throw std::runtime_error("TaraskFrameRing: ring too large for dynamic offsets.");
+        }
+        m_taraskDevice.createBuffer(m_regionSize * frameCount, usage,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                    m_buffer, m_allocation);
+        if (m_allocation.mappedData == nullptr)
+        {
+            throw std::runtime_error("TaraskFrameRing: ring memory is not mapped.");
+        }
+    }
+
+    TaraskFrameRing::~TaraskFrameRing()
+    {
+        m_taraskDevice.deletionQueue().destroyBuffer(m_buffer, m_allocation);
+    }
+
+    void TaraskFrameRing::beginFrame(uint32_t frame)
+    {
+        if (frame >= m_frameCount)
+        {
+            throw std::runtime_error("TaraskFrameRing: frame out of range.");
+        }
+        m_regionStart = m_regionSize * frame;
+        m_head.store(0, std::memory_order_relaxed);
+    }
+
+    TaraskFrameRing::Allocation TaraskFrameRing::allocate(VkDeviceSize size,
+                                                          VkDeviceSize alignment)
+    {
+        // the region start is aligned for any binding, so aligning within it is enough
+        VkDeviceSize head = m_head.load(std::memory_order_relaxed);
+        VkDeviceSize offset;
+        do
+        {
+            offset = alignUp(head, alignment);
+            if (offset + size > m_regionSize)
+            {
+                throw std::runtime_error("TaraskFrameRing: frame region exhausted.");
+            }
+        } while (!m_head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+        offset += m_regionStart;
+        return {static_cast<char *>(m_allocation.mappedData) + offset,
+                static_cast<uint32_t>(offset)};
+    }
+
+    VkDeviceSize TaraskFrameRing::uniformAlignment() const
+    {
+        return std::max<VkDeviceSize>(
+            m_taraskDevice.properties.limits.minUniformBufferOffsetAlignment, 1);
+    }
+
+    VkDeviceSize TaraskFrameRing::storageAlignment() const
+    {
+        return std::max<VkDeviceSize>(
+            m_taraskDevice.properties.limits.minStorageBufferOffsetAlignment, 1);
+    }
+
+    VkDeviceSize TaraskFrameRing::frameSize(VkDeviceSize bytes, uint32_t count,
+                                            VkDeviceSize alignment)
+    {
+        return bytes + VkDeviceSize{count} * (alignment - 1);
+    }
+} // namespace tarask
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "tarask_device.hpp"
+
+// std lib headers
+#include <atomic>
+#include <cstdint>
+
+namespace tarask
+{
+    // One persistently mapped, host coherent buffer split into a region per frame slot. A frame
+    // bump allocates its uniform and storage data from its own region and binds them with
+    // dynamic offsets into the same descriptor set, so per frame data never needs new
+    // descriptors or a push constant per draw. A region is only reused once the slot's
+    // previous frame has completed, the same rule as for its command buffer.
+    class TaraskFrameRing
+    {
+    public:
+        struct Allocation
+        {
+            void *data;
+            // from the start of buffer(), the dynamic offset to bind it with
+            uint32_t offset;
+        };
+
+        TaraskFrameRing(TaraskDevice &device, VkDeviceSize bytesPerFrame, uint32_t frameCount,
+                        VkBufferUsageFlags usage);
+        ~TaraskFrameRing();
+
+        TaraskFrameRing(const TaraskFrameRing &) = delete;
+        TaraskFrameRing &operator=(const TaraskFrameRing &) = delete;
+
+        // Starts allocating from frame's region again.
+        void beginFrame(uint32_t frame);
+        // size bytes aligned to alignment, from any thread. Throws once the region is full.
+        Allocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+        template <typename T>
+        T *allocate(uint32_t count, VkDeviceSize alignment, uint32_t &offset)
+        {
+            Allocation allocation = allocate(sizeof(T) * VkDeviceSize{count}, alignment);
+            offset = allocation.offset;
+            return static_cast<T *>(allocation.data);
+        }
+
+        VkBuffer buffer() const { return m_buffer; }
+        VkDeviceSize uniformAlignment() const;
+        VkDeviceSize storageAlignment() const;
+        // the most bytes one frame can allocate, allowing for the worst case padding of count
+        // allocations aligned to alignment
+        static VkDeviceSize frameSize(VkDeviceSize bytes, uint32_t count, VkDeviceSize alignment);
+
+    private:
+        TaraskDevice &m_taraskDevice;
+        VkBuffer m_buffer;
+        TaraskAllocation m_allocation;
+        VkDeviceSize m_regionSize;
+        uint32_t m_frameCount;
+        VkDeviceSize m_regionStart = 0;
+        // within the current region
+        std::atomic<VkDeviceSize> m_head{0};
+    };
+} // namespace tarask
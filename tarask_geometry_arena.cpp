@@ -0,0 +1,106 @@
+#include "tarask_geometry_arena.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskGeometryArena::TaraskGeometryArena(TaraskDevice &device, uint32_t vertexCapacity,
+                                             uint32_t indexCapacity)
+        : m_taraskDevice{device}, m_vertexCapacity{vertexCapacity}, m_indexCapacity{indexCapacity}
+    {
+        m_taraskDevice.createBuffer(sizeof(TaraskModel::Vertex) * VkDeviceSize{vertexCapacity},
+                                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vertexBuffer,
+                                    m_vertexAllocation);
+        m_taraskDevice.createBuffer(sizeof(uint32_t) * VkDeviceSize{indexCapacity},
+                                    VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_indexBuffer,
+                                    m_indexAllocation);
+    }
+
+    TaraskGeometryArena::~TaraskGeometryArena()
+    {
+        // frames may still draw from the buffers and a copy may still be writing into them
+        TaraskDevice &device = m_taraskDevice;
+        m_taraskDevice.deletionQueue().enqueue(
+            [&device, ticket = m_uploadTicket, indexBuffer = m_indexBuffer,
+             indexAllocation = m_indexAllocation, vertexBuffer = m_vertexBuffer,
+             vertexAllocation = m_vertexAllocation]() mutable
+            {
+                device.uploader().wait(ticket);
+                device.destroyBuffer(indexBuffer, indexAllocation);
+                device.destroyBuffer(vertexBuffer, vertexAllocation);
+            });
+    }
+
+    TaraskMesh TaraskGeometryArena::addMesh(const std::vector<TaraskModel::Vertex> &vertices,
+                                            const std::vector<uint32_t> &indices)
+    {
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+        auto indexCount = static_cast<uint32_t>(indices.size());
+        if (vertexCount > m_vertexCapacity - m_vertexCount ||
+            indexCount > m_indexCapacity - m_indexCount)
+        {
+            throw std::runtime_error("TaraskGeometryArena: out of space for mesh.");
+        }
+
+        TaraskMesh mesh{};
+        mesh.firstIndex = m_indexCount;
+        mesh.indexCount = indexCount;
+        mesh.vertexOffset = static_cast<int32_t>(m_vertexCount);
+        if (vertexCount > 0)
+        {
+            glm::vec2 minPosition = vertices[0].position;
+            glm::vec2 maxPosition = vertices[0].position;
+            for (const auto &vertex : vertices)
+            {
+                minPosition = glm::min(minPosition, vertex.position);
+                maxPosition = glm::max(maxPosition, vertex.position);
+            }
+            mesh.boundsCenter = 0.5f * (minPosition + maxPosition);
+            for (const auto &vertex : vertices)
+            {
+                mesh.boundsRadius =
+                    std::max(mesh.boundsRadius, glm::length(vertex.position - mesh.boundsCenter));
+            }
+        }
+
+        auto &uploader = m_taraskDevice.uploader();
+        uploader.uploadBuffer(m_vertexBuffer, sizeof(TaraskModel::Vertex) * VkDeviceSize{m_vertexCount},
+                              vertices.data(), sizeof(TaraskModel::Vertex) * VkDeviceSize{vertexCount});
+        uploader.uploadBuffer(m_indexBuffer, sizeof(uint32_t) * VkDeviceSize{m_indexCount},
+                              indices.data(), sizeof(uint32_t) * VkDeviceSize{indexCount});
+        m_uploadTicket = uploader.flush();
+        m_uploaded = false;
+
+        m_vertexCount += vertexCount;
+        m_indexCount += indexCount;
+        return mesh;
+    }
+
+    bool TaraskGeometryArena::isReady()
+    {
+        if (!m_uploaded)
+        {
+            m_uploaded = m_taraskDevice.uploader().isVisibleToGraphics(m_uploadTicket);
+        }
+        return m_uploaded;
+    }
+
+    void TaraskGeometryArena::wait()
+    {
+        m_taraskDevice.uploader().wait(m_uploadTicket);
+        m_uploaded = true;
+    }
+
+    void TaraskGeometryArena::bind(VkCommandBuffer commandBuffer)
+    {
+        VkBuffer vertexBuffers[] = {m_vertexBuffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+} // namespace tarask
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "tarask_device.hpp"
+#include "tarask_model.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <vector>
+
+namespace tarask
+{
+    // Location of one mesh inside a TaraskGeometryArena, in the units a
+    // VkDrawIndexedIndirectCommand expects.
+    struct TaraskMesh
+    {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+        // bounding circle in model space, used for culling
+        glm::vec2 boundsCenter{0.0f, 0.0f};
+        float boundsRadius = 0.0f;
+    };
+
+    // One device local vertex buffer and one index buffer shared by every mesh, so a whole
+    // scene is drawn after a single bind. Meshes are appended and live as long as the arena,
+    // there is no per mesh free.
+    class TaraskGeometryArena
+    {
+    public:
+        static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 1024 * 1024;
+        static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 3 * 1024 * 1024;
+
+        TaraskGeometryArena(TaraskDevice &device,
+                            uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+                            uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+        ~TaraskGeometryArena();
+
+        TaraskGeometryArena(const TaraskGeometryArena &) = delete;
+        TaraskGeometryArena &operator=(const TaraskGeometryArena &) = delete;
+
+        // Indices are relative to the mesh's own vertices. The upload is asynchronous.
+        TaraskMesh addMesh(const std::vector<TaraskModel::Vertex> &vertices,
+                           const std::vector<uint32_t> &indices);
+        // True once every mesh added so far can be drawn, see
+        // TaraskUploader::isVisibleToGraphics.
+        bool isReady();
+        // Blocks until every mesh added so far has landed on the device.
+        void wait();
+        void bind(VkCommandBuffer commandBuffer);
+
+        uint32_t vertexCount() { return m_vertexCount; }
+        uint32_t indexCount() { return m_indexCount; }
+
+    private:
+        TaraskDevice &m_taraskDevice;
+        VkBuffer m_vertexBuffer;
+        TaraskAllocation m_vertexAllocation;
+        VkBuffer m_indexBuffer;
+        TaraskAllocation m_indexAllocation;
+        uint32_t m_vertexCapacity;
+        uint32_t m_indexCapacity;
+        uint32_t m_vertexCount = 0;
+        uint32_t m_indexCount = 0;
+
+        UploadTicket m_uploadTicket = 0;
+        bool m_uploaded = true;
+    };
+} // namespace tarask
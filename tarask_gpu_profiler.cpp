@@ -0,0 +1,239 @@
+#include "tarask_gpu_profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tarask
+{
+    bool TaraskGpuProfiler::isSupported(TaraskDevice &device)
+    {
+        return device.properties.limits.timestampComputeAndGraphics;
+    }
+
+    TaraskGpuProfiler::TaraskGpuProfiler(TaraskDevice &device, uint32_t frameCount,
+                                         bool pipelineStatistics)
+        : m_taraskDevice{device},
+          m_nanosecondsPerTick{device.properties.limits.timestampPeriod},
+          m_frames(frameCount)
+    {
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_taraskDevice.getPhysicalDevice(), &familyCount,
+                                                 nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(m_taraskDevice.getPhysicalDevice(), &familyCount,
+                                                 families.data());
+        uint32_t validBits =
+            families[m_taraskDevice.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+        m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = 2 * MAX_SCOPES * frameCount;
+        if (vkCreateQueryPool(m_taraskDevice.device(), &poolInfo, nullptr, &m_timestampPool) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskGpuProfiler: failed to create timestamp query pool.");
+        }
+
+        // the statistics cover secondary command buffers, so they have to inherit the query
+        if (pipelineStatistics && m_taraskDevice.supportsPipelineStatistics() &&
+            m_taraskDevice.supportsInheritedQueries())
+        {
+            VkQueryPoolCreateInfo statisticsInfo{};
+            statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statisticsInfo.queryCount = frameCount;
+            statisticsInfo.pipelineStatistics = STATISTICS;
+            if (vkCreateQueryPool(m_taraskDevice.device(), &statisticsInfo, nullptr,
+                                  &m_statisticsPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error(
+                    "TaraskGpuProfiler: failed to create pipeline statistics query pool.");
+            }
+        }
+
+        // ScopeTiming points into m_history, it must never reallocate
+        m_history.reserve(MAX_SCOPES);
+        m_results.resize(2 * MAX_SCOPES);
+    }
+
+    TaraskGpuProfiler::~TaraskGpuProfiler()
+    {
+        // the pools are written by frames that may still be in flight
+        VkDevice device = m_taraskDevice.device();
+        m_taraskDevice.deletionQueue().enqueue(
+            [device, timestampPool = m_timestampPool, statisticsPool = m_statisticsPool]()
+            {
+                if (statisticsPool != VK_NULL_HANDLE)
+                {
+                    vkDestroyQueryPool(device, statisticsPool, nullptr);
+                }
+                vkDestroyQueryPool(device, timestampPool, nullptr);
+            });
+    }
+
+    void TaraskGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+    {
+        collect(frameIndex);
+        m_currentFrame = frameIndex;
+        m_nextQuery = 0;
+        m_openScopes.clear();
+        m_frames[frameIndex].scopes.clear();
+        m_frames[frameIndex].statisticsWritten = false;
+        vkCmdResetQueryPool(commandBuffer, m_timestampPool, 2 * MAX_SCOPES * frameIndex,
+                            2 * MAX_SCOPES);
+        if (m_statisticsPool != VK_NULL_HANDLE)
+        {
+            vkCmdResetQueryPool(commandBuffer, m_statisticsPool, frameIndex, 1);
+        }
+    }
+
+    void TaraskGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string &name)
+    {
+        auto &frame = m_frames[m_currentFrame];
+        if (m_nextQuery + 2 > 2 * MAX_SCOPES)
+        {
+            throw std::runtime_error("TaraskGpuProfiler: too many scopes in one frame.");
+        }
+        uint32_t query = 2 * MAX_SCOPES * m_currentFrame + m_nextQuery;
+        m_nextQuery += 2;
+        m_openScopes.push_back(static_cast<uint32_t>(frame.scopes.size()));
+        frame.scopes.push_back({scopeIndex(name), query});
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool,
+                            query);
+    }
+
+    void TaraskGpuProfiler::endScope(VkCommandBuffer commandBuffer)
+    {
+        if (m_openScopes.empty())
+        {
+            throw std::runtime_error("TaraskGpuProfiler: endScope without beginScope.");
+        }
+        const ScopeRecord &record = m_frames[m_currentFrame].scopes[m_openScopes.back()];
+        m_openScopes.pop_back();
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool,
+                            record.beginQuery + 1);
+    }
+
+    void TaraskGpuProfiler::beginStatistics(VkCommandBuffer commandBuffer)
+    {
+        if (m_statisticsPool != VK_NULL_HANDLE)
+        {
+            vkCmdBeginQuery(commandBuffer, m_statisticsPool, m_currentFrame, 0);
+        }
+    }
+
+    void TaraskGpuProfiler::endStatistics(VkCommandBuffer commandBuffer)
+    {
+        if (m_statisticsPool != VK_NULL_HANDLE)
+        {
+            vkCmdEndQuery(commandBuffer, m_statisticsPool, m_currentFrame);
+            m_frames[m_currentFrame].statisticsWritten = true;
+        }
+    }
+
+    void TaraskGpuProfiler::collect(uint32_t frameIndex)
+    {
+        auto &frame = m_frames[frameIndex];
+        if (frame.scopes.empty())
+        {
+            return;
+        }
+
+        // the slot's queries were written in order, one range covers all of them
+        uint32_t queryCount = 2 * static_cast<uint32_t>(frame.scopes.size());
+        VkResult result = vkGetQueryPoolResults(
+            m_taraskDevice.device(), m_timestampPool, 2 * MAX_SCOPES * frameIndex, queryCount,
+            queryCount * sizeof(uint64_t), m_results.data(), sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS)
+        {
+            m_lastFrame.clear();
+            uint32_t firstQuery = 2 * MAX_SCOPES * frameIndex;
+            for (const auto &record : frame.scopes)
+            {
+                uint64_t begin = m_results[record.beginQuery - firstQuery] & m_timestampMask;
+                uint64_t end = m_results[record.beginQuery - firstQuery + 1] & m_timestampMask;
+                double ms = static_cast<double>((end - begin) & m_timestampMask) *
+                            m_nanosecondsPerTick * 1e-6;
+
+                auto &history = m_history[record.scope];
+                if (history.samples.size() < HISTORY)
+                {
+                    history.samples.push_back(ms);
+                }
+                else
+                {
+                    history.samples[history.next] = ms;
+                }
+                history.next = (history.next + 1) % HISTORY;
+                history.lastMs = ms;
+                m_lastFrame.push_back({&history.name, ms});
+            }
+        }
+        // results that are not ready yet are dropped rather than waited for
+        frame.scopes.clear();
+
+        if (frame.statisticsWritten)
+        {
+            uint64_t counts[2];
+            if (vkGetQueryPoolResults(m_taraskDevice.device(), m_statisticsPool, frameIndex, 1,
+                                      sizeof(counts), counts, sizeof(counts),
+                                      VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+            {
+                // results come in the order of the statistic bits
+                m_vertexInvocations = counts[0];
+                m_fragmentInvocations = counts[1];
+            }
+            frame.statisticsWritten = false;
+        }
+    }
+
+    std::vector<TaraskGpuProfiler::ScopeStats> TaraskGpuProfiler::stats() const
+    {
+        std::vector<ScopeStats> stats;
+        stats.reserve(m_history.size());
+        std::vector<double> sorted;
+        for (const auto &history : m_history)
+        {
+            ScopeStats scope{};
+            scope.name = history.name;
+            scope.lastMs = history.lastMs;
+            scope.samples = static_cast<uint32_t>(history.samples.size());
+            if (!history.samples.empty())
+            {
+                sorted = history.samples;
+                std::sort(sorted.begin(), sorted.end());
+                double total = 0.0;
+                for (double sample : sorted)
+                {
+                    total += sample;
+                }
+                scope.minMs = sorted.front();
+                scope.avgMs = total / sorted.size();
+                scope.p99Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+            }
+            stats.push_back(scope);
+        }
+        return stats;
+    }
+
+    uint32_t TaraskGpuProfiler::scopeIndex(const std::string &name)
+    {
+        auto it = m_scopeIndices.find(name);
+        if (it != m_scopeIndices.end())
+        {
+            return it->second;
+        }
+        if (m_history.size() == MAX_SCOPES)
+        {
+            throw std::runtime_error("TaraskGpuProfiler: too many distinct scope names.");
+        }
+        uint32_t index = static_cast<uint32_t>(m_history.size());
+        m_history.push_back({name, {}, 0, 0.0});
+        m_history.back().samples.reserve(HISTORY);
+        m_scopeIndices.emplace(name, index);
+        return index;
+    }
+} // namespace tarask
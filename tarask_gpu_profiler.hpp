@@ -0,0 +1,124 @@
+#pragma once
+
+#include "tarask_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tarask
+{
+    // Times named scopes of a command buffer with timestamp queries. Every frame slot owns a
+    // range of the query pool, and its results are read back the next time the slot begins,
+    // which is frameCount frames later, without waiting on the GPU.
+    class TaraskGpuProfiler
+    {
+    public:
+        static constexpr uint32_t MAX_SCOPES = 32;
+        // samples kept per scope for the rolling statistics
+        static constexpr uint32_t HISTORY = 256;
+
+        struct ScopeStats
+        {
+            std::string name;
+            double lastMs = 0.0;
+            double minMs = 0.0;
+            double avgMs = 0.0;
+            double p99Ms = 0.0;
+            uint32_t samples = 0;
+        };
+
+        struct ScopeTiming
+        {
+            const std::string *name;
+            double ms;
+        };
+
+        // true when every graphics and compute queue can write timestamps
+        static bool isSupported(TaraskDevice &device);
+
+        TaraskGpuProfiler(TaraskDevice &device, uint32_t frameCount,
+                          bool pipelineStatistics = false);
+        ~TaraskGpuProfiler();
+
+        TaraskGpuProfiler(const TaraskGpuProfiler &) = delete;
+        TaraskGpuProfiler &operator=(const TaraskGpuProfiler &) = delete;
+
+        // Collects the slot's previous results, then resets its queries. Call it first thing
+        // after vkBeginCommandBuffer.
+        void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+        // Scopes may nest but must all end before the command buffer does. A scope inside a
+        // render pass must begin and end in the same subpass.
+        void beginScope(VkCommandBuffer commandBuffer, const std::string &name);
+        void endScope(VkCommandBuffer commandBuffer);
+        // Counts vertex and fragment invocations between the two calls, outside a render pass.
+        // Does nothing unless pipeline statistics were requested and the device supports them
+        // and inherited queries.
+        void beginStatistics(VkCommandBuffer commandBuffer);
+        void endStatistics(VkCommandBuffer commandBuffer);
+
+        // Reads the slot's results if they are ready. beginFrame does this already, call it
+        // directly to drain the last frames once the device is idle.
+        void collect(uint32_t frameIndex);
+
+        // scopes of the most recently collected frame
+        const std::vector<ScopeTiming> &lastFrame() const { return m_lastFrame; }
+        std::vector<ScopeStats> stats() const;
+        bool hasPipelineStatistics() const { return m_statisticsPool != VK_NULL_HANDLE; }
+        // what secondary command buffers executed between beginStatistics and endStatistics
+        // have to inherit
+        VkQueryPipelineStatisticFlags pipelineStatistics() const
+        {
+            return hasPipelineStatistics() ? STATISTICS : 0;
+        }
+        uint64_t vertexInvocations() const { return m_vertexInvocations; }
+        uint64_t fragmentInvocations() const { return m_fragmentInvocations; }
+
+    private:
+        static constexpr VkQueryPipelineStatisticFlags STATISTICS =
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        struct ScopeRecord
+        {
+            uint32_t scope;
+            uint32_t beginQuery;
+        };
+
+        struct FrameSlot
+        {
+            std::vector<ScopeRecord> scopes;
+            bool statisticsWritten = false;
+        };
+
+        struct ScopeHistory
+        {
+            std::string name;
+            std::vector<double> samples;
+            uint32_t next = 0;
+            double lastMs = 0.0;
+        };
+
+        uint32_t scopeIndex(const std::string &name);
+
+        TaraskDevice &m_taraskDevice;
+        VkQueryPool m_timestampPool = VK_NULL_HANDLE;
+        VkQueryPool m_statisticsPool = VK_NULL_HANDLE;
+        double m_nanosecondsPerTick;
+        // bits the graphics queue actually writes, the rest are undefined
+        uint64_t m_timestampMask;
+        std::vector<FrameSlot> m_frames;
+        uint32_t m_currentFrame = 0;
+        uint32_t m_nextQuery = 0;
+        // indices into m_frames[m_currentFrame].scopes of the scopes still open
+        std::vector<uint32_t> m_openScopes;
+        std::unordered_map<std::string, uint32_t> m_scopeIndices;
+        std::vector<ScopeHistory> m_history;
+        std::vector<ScopeTiming> m_lastFrame;
+        std::vector<uint64_t> m_results;
+        uint64_t m_vertexInvocations = 0;
+        uint64_t m_fragmentInvocations = 0;
+    };
+} // namespace tarask
@@ -0,0 +1,265 @@
+#include "tarask_job_system.hpp"
+
+#include "tarask_trace.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace tarask
+{
+    namespace
+    {
+        // which job system the current thread works for, and as which slot
+        thread_local const TaraskJobSystem *t_jobSystem = nullptr;
+        thread_local uint32_t t_threadIndex = 0;
+
+        // idle rounds a worker spins through before it goes to sleep
+        constexpr uint32_t SPIN_ROUNDS = 64;
+    } // namespace
+
+    TaraskJobSystem::TaraskJobSystem(uint32_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        threadCount = std::max(threadCount, 2u);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            m_workers.emplace_back(&TaraskJobSystem::workerLoop, this, i);
+        }
+    }
+
+    TaraskJobSystem::~TaraskJobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_sleepMutex};
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    void TaraskJobSystem::run(Job job, TaraskJobCounter *counter, JobPriority priority)
+    {
+        if (counter != nullptr)
+        {
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        push(Entry{std::move(job), counter}, priority);
+    }
+
+    void TaraskJobSystem::runAfter(TaraskJobCounter &dependency, Job job,
+                                   TaraskJobCounter *counter, JobPriority priority)
+    {
+        if (counter != nullptr)
+        {
+            // pending from now on, so a wait on it covers the continuation as well
+            counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock{dependency.m_mutex};
+            if (dependency.m_pending.load(std::memory_order_acquire) != 0)
+            {
+                dependency.m_continuations.push_back(
+                    [this, job = std::move(job), counter, priority]() mutable
+                    { push(Entry{std::move(job), counter}, priority); });
+                return;
+            }
+        }
+        push(Entry{std::move(job), counter}, priority);
+    }
+
+    void TaraskJobSystem::wait(TaraskJobCounter &counter)
+    {
+        TARASK_TRACE_SCOPE("waitJobs");
+        uint32_t threadIndex = currentThreadIndex();
+        while (!counter.isDone())
+        {
+            if (!runOne(threadIndex, false))
+            {
+                std::this_thread::yield();
+            }
+        }
+        // the last finish() may still hold the mutex, don't let the caller free it under it
+        std::lock_guard<std::mutex> lock{counter.m_mutex};
+    }
+
+    void TaraskJobSystem::parallelFor(uint32_t count,
+                                      const std::function<void(uint32_t, uint32_t)> &task,
+                                      uint32_t grainSize)
+    {
+        grainSize = std::max(grainSize, 1u);
+        if (count <= grainSize)
+        {
+            // a single job, not worth a trip through the queues
+            uint32_t threadIndex = currentThreadIndex();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                task(i, threadIndex);
+            }
+            return;
+        }
+
+        TaraskJobCounter counter;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        for (uint32_t first = 0; first < count; first += grainSize)
+        {
+            uint32_t last = first + std::min(grainSize, count - first);
+            run(
+                [&, first, last](uint32_t threadIndex)
+                {
+                    try
+                    {
+                        for (uint32_t i = first; i < last; i++)
+                        {
+                            task(i, threadIndex);
+                        }
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock{errorMutex};
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+                },
+                &counter);
+        }
+        wait(counter);
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void TaraskJobSystem::workerLoop(uint32_t threadIndex)
+    {
+        TARASK_TRACE_THREAD("job worker");
+        t_jobSystem = this;
+        t_threadIndex = threadIndex;
+        uint32_t idleRounds = 0;
+        while (true)
+        {
+            if (runOne(threadIndex, true))
+            {
+                idleRounds = 0;
+                continue;
+            }
+            if (++idleRounds < SPIN_ROUNDS)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{m_sleepMutex};
+            m_wake.wait(lock, [this] { return m_stopping || m_queued.load() != 0; });
+            if (m_stopping && m_queued.load() == 0)
+            {
+                return;
+            }
+            idleRounds = 0;
+        }
+    }
+
+    uint32_t TaraskJobSystem::currentThreadIndex() const
+    {
+        return t_jobSystem == this ? t_threadIndex : 0;
+    }
+
+    void TaraskJobSystem::push(Entry entry, JobPriority priority)
+    {
+        Queue &queue = priority == JobPriority::Background
+                           ? m_background
+                           : *m_queues[currentThreadIndex()];
+        {
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            queue.entries.push_back(std::move(entry));
+        }
+        m_queued.fetch_add(1);
+        {
+            // a worker between checking m_queued and sleeping would miss a bare notify
+            std::lock_guard<std::mutex> lock{m_sleepMutex};
+        }
+        m_wake.notify_one();
+    }
+
+    bool TaraskJobSystem::pop(Queue &queue, bool back, Entry &entry)
+    {
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (queue.entries.empty())
+        {
+            return false;
+        }
+        if (back)
+        {
+            entry = std::move(queue.entries.back());
+            queue.entries.pop_back();
+        }
+        else
+        {
+            entry = std::move(queue.entries.front());
+            queue.entries.pop_front();
+        }
+        return true;
+    }
+
+    bool TaraskJobSystem::runOne(uint32_t threadIndex, bool allowBackground)
+    {
+        Entry entry;
+        bool found = pop(*m_queues[threadIndex], true, entry);
+        for (uint32_t i = 1; !found && i < m_queues.size(); i++)
+        {
+            // start with the next slot so thieves spread over the victims
+            found = pop(*m_queues[(threadIndex + i) % m_queues.size()], false, entry);
+            if (found)
+            {
+                m_steals.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (!found && allowBackground)
+        {
+            found = pop(m_background, false, entry);
+        }
+        if (!found)
+        {
+            return false;
+        }
+
+        m_queued.fetch_sub(1);
+        entry.job(threadIndex);
+        finish(entry.counter);
+        return true;
+    }
+
+    void TaraskJobSystem::finish(TaraskJobCounter *counter)
+    {
+        if (counter == nullptr)
+        {
+            return;
+        }
+        std::vector<std::function<void()>> continuations;
+        {
+            // decrement under the lock so runAfter never misses the transition to zero
+            std::lock_guard<std::mutex> lock{counter->m_mutex};
+            if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                continuations.swap(counter->m_continuations);
+            }
+        }
+        for (auto &continuation : continuations)
+        {
+            continuation();
+        }
+    }
+} // namespace tarask
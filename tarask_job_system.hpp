@@ -0,0 +1,118 @@
+#pragma once
+
+// std lib headers
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tarask
+{
+    // Number of unfinished jobs started against it. Waiting on a counter, or running a
+    // continuation after it, is how jobs express dependencies.
+    class TaraskJobCounter
+    {
+    public:
+        TaraskJobCounter() = default;
+        TaraskJobCounter(const TaraskJobCounter &) = delete;
+        TaraskJobCounter &operator=(const TaraskJobCounter &) = delete;
+
+        bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class TaraskJobSystem;
+
+        std::atomic<uint32_t> m_pending{0};
+        // guards the continuations and the last decrement, see TaraskJobSystem::finish
+        std::mutex m_mutex;
+        std::vector<std::function<void()>> m_continuations;
+    };
+
+    enum class JobPriority
+    {
+        // work a frame waits on, also run by threads waiting on a counter
+        Frame,
+        // long jobs such as pipeline builds, only ever picked up by idle workers
+        Background,
+    };
+
+    // Work stealing scheduler. Every worker owns a deque: it pushes and pops its own jobs at
+    // the back, which keeps recently split work hot in its cache, and idle workers steal the
+    // oldest jobs from the front of the others. Threads that are not workers share slot 0,
+    // and waiting on a counter helps run frame jobs instead of blocking.
+    class TaraskJobSystem
+    {
+    public:
+        using Job = std::function<void(uint32_t threadIndex)>;
+
+        // 0 uses one thread per core. There is always at least one worker, so background
+        // jobs make progress whatever the caller does.
+        explicit TaraskJobSystem(uint32_t threadCount = 0);
+        // runs the jobs still queued, then joins the workers
+        ~TaraskJobSystem();
+
+        TaraskJobSystem(const TaraskJobSystem &) = delete;
+        TaraskJobSystem &operator=(const TaraskJobSystem &) = delete;
+
+        // Workers plus slot 0. A job's threadIndex is below it, so jobs can index per thread
+        // resources with it. Only one non worker thread at a time may run jobs as slot 0, that
+        // is call wait() or parallelFor().
+        uint32_t threadCount() const { return static_cast<uint32_t>(m_queues.size()); }
+
+        // Queues job. counter, if any, counts it as pending until it returns. Jobs must not
+        // throw, parallelFor catches for its tasks.
+        void run(Job job, TaraskJobCounter *counter = nullptr,
+                 JobPriority priority = JobPriority::Frame);
+        // Queues job once dependency has no pending jobs left, without blocking anyone.
+        void runAfter(TaraskJobCounter &dependency, Job job, TaraskJobCounter *counter = nullptr,
+                      JobPriority priority = JobPriority::Frame);
+        // Runs frame jobs until counter has none pending. The counter may be destroyed as soon
+        // as this returns.
+        void wait(TaraskJobCounter &counter);
+
+        // Calls task(index, threadIndex) for every index below count, grainSize indices per
+        // job, and returns once all are done. The first exception a task throws is rethrown.
+        void parallelFor(uint32_t count,
+                         const std::function<void(uint32_t, uint32_t)> &task,
+                         uint32_t grainSize = 1);
+
+        // jobs taken from another thread's deque, to see whether the load balances itself
+        uint64_t stealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+    private:
+        struct Entry
+        {
+            Job job;
+            TaraskJobCounter *counter;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Entry> entries;
+        };
+
+        void workerLoop(uint32_t threadIndex);
+        uint32_t currentThreadIndex() const;
+        void push(Entry entry, JobPriority priority);
+        // pops from the own deque, then steals, then background work if allowed
+        bool runOne(uint32_t threadIndex, bool allowBackground);
+        bool pop(Queue &queue, bool back, Entry &entry);
+        void finish(TaraskJobCounter *counter);
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        Queue m_background;
+        std::vector<std::thread> m_workers;
+        // queued jobs of either priority, what sleeping workers wait for
+        std::atomic<uint32_t> m_queued{0};
+        std::atomic<uint64_t> m_steals{0};
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+    };
+} // namespace tarask
@@ -1,19 +1,86 @@
 #include "tarask_model.hpp"
 
+#include "tarask_utils.hpp"
+
 #include <cassert>
 #include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+    struct VertexHash
+    {
+        size_t operator()(const tarask::TaraskModel::Vertex &vertex) const
+        {
+            size_t seed = 0;
+            tarask::hashCombine(seed, vertex.position.x, vertex.position.y, vertex.color.x,
+                                vertex.color.y, vertex.color.z);
+            return seed;
+        }
+    };
+} // namespace
 
 namespace tarask
 {
     TaraskModel::TaraskModel(TaraskDevice &device, const std::vector<Vertex> &vertices)
         : taraskDevice{device}
+    {
+        std::vector<Vertex> uniqueVertices;
+        std::vector<uint32_t> indices;
+        std::unordered_map<Vertex, uint32_t, VertexHash> vertexIndices;
+        uniqueVertices.reserve(vertices.size());
+        indices.reserve(vertices.size());
+        for (const auto &vertex : vertices)
+        {
+            auto it = vertexIndices.find(vertex);
+            if (it == vertexIndices.end())
+            {
+                it = vertexIndices.emplace(vertex, static_cast<uint32_t>(uniqueVertices.size()))
+                         .first;
+                uniqueVertices.push_back(vertex);
+            }
+            indices.push_back(it->second);
+        }
+
+        if (uniqueVertices.size() < vertices.size())
+        {
+            createVertexBuffer(uniqueVertices);
+            createIndexBuffer(indices);
+        }
+        else
+        {
+            createVertexBuffer(vertices);
+        }
+        uploadTicket = taraskDevice.uploader().flush();
+    }
+
+    TaraskModel::TaraskModel(TaraskDevice &device, const std::vector<Vertex> &vertices,
+                             const std::vector<uint32_t> &indices)
+        : taraskDevice{device}
     {
         createVertexBuffer(vertices);
+        createIndexBuffer(indices);
+        uploadTicket = taraskDevice.uploader().flush();
     }
+
     TaraskModel::~TaraskModel()
     {
-        vkDestroyBuffer(taraskDevice.device(), vertexBuffer, nullptr);
-        vkFreeMemory(taraskDevice.device(), vertexBufferMemory, nullptr);
+        // frames still drawing the model keep the buffers alive, and so does a copy that no
+        // frame has waited on yet
+        TaraskDevice &device = taraskDevice;
+        taraskDevice.deletionQueue().enqueue(
+            [&device, ticket = uploadTicket, vertexBuffer = vertexBuffer,
+             vertexAllocation = vertexBufferAllocation, indexBuffer = indexBuffer,
+             indexAllocation = indexBufferAllocation]() mutable
+            {
+                device.uploader().wait(ticket);
+                device.destroyBuffer(vertexBuffer, vertexAllocation);
+                if (indexBuffer != VK_NULL_HANDLE)
+                {
+                    device.destroyBuffer(indexBuffer, indexAllocation);
+                }
+            });
     }
 
     void TaraskModel::createVertexBuffer(const std::vector<Vertex> &vertices)
@@ -21,14 +88,54 @@ namespace tarask
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Tarask::Model::vertexCount must be at least 3.");
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        taraskDevice.createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                  vertexBuffer, vertexBufferMemory);
-        void *data;
-        vkMapMemory(taraskDevice.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(taraskDevice.device(), vertexBufferMemory);
+        uploadToDeviceLocal(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(), bufferSize,
+                            vertexBuffer, vertexBufferAllocation);
+    }
+
+    void TaraskModel::createIndexBuffer(const std::vector<uint32_t> &indices)
+    {
+        indexCount = static_cast<uint32_t>(indices.size());
+        hasIndexBuffer = indexCount > 0;
+        if (!hasIndexBuffer)
+        {
+            return;
+        }
+
+        // 16 bit indices halve the index bandwidth whenever every vertex is addressable
+        if (vertexCount <= std::numeric_limits<uint16_t>::max() + 1u)
+        {
+            indexType = VK_INDEX_TYPE_UINT16;
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            uploadToDeviceLocal(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, shortIndices.data(),
+                                sizeof(uint16_t) * indexCount, indexBuffer,
+                                indexBufferAllocation);
+        }
+        else
+        {
+            indexType = VK_INDEX_TYPE_UINT32;
+            uploadToDeviceLocal(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(),
+                                sizeof(uint32_t) * indexCount, indexBuffer,
+                                indexBufferAllocation);
+        }
+    }
+
+    void TaraskModel::uploadToDeviceLocal(VkBufferUsageFlags usage, const void *data,
+                                          VkDeviceSize size, VkBuffer &buffer,
+                                          TaraskAllocation &allocation)
+    {
+        taraskDevice.createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, allocation);
+        // the data is copied into the staging ring right away, the caller's copy can go
+        taraskDevice.uploader().uploadBuffer(buffer, 0, data, size);
+    }
+
+    bool TaraskModel::isReady()
+    {
+        if (!uploaded)
+        {
+            uploaded = taraskDevice.uploader().isVisibleToGraphics(uploadTicket);
+        }
+        return uploaded;
     }
 
     void TaraskModel::bind(VkCommandBuffer commandBuffer)
@@ -36,11 +143,23 @@ namespace tarask
         VkBuffer vertexBuffers[] = {vertexBuffer};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+        if (hasIndexBuffer)
+        {
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+        }
     }
 
-    void TaraskModel::draw(VkCommandBuffer commandBuffer)
+    void TaraskModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount,
+                           uint32_t firstInstance)
     {
-        vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+        if (hasIndexBuffer)
+        {
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+        }
+        else
+        {
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+        }
     }
 
     std::vector<VkVertexInputBindingDescription> TaraskModel::Vertex::getBindingDescriptions()
@@ -66,4 +185,4 @@ namespace tarask
         attributeDescriptions[1].offset = offsetof(Vertex, color);
         return attributeDescriptions;
     }
-}
\ No newline at end of file
+}
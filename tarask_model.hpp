@@ -21,23 +21,46 @@ namespace tarask
 
             static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+            bool operator==(const Vertex &other) const
+            {
+                return position == other.position && color == other.color;
+            }
         };
 
+        // Identical vertices are merged and the model is drawn indexed when that saves anything.
         TaraskModel(TaraskDevice &device, const std::vector<Vertex> &vertices);
+        TaraskModel(TaraskDevice &device, const std::vector<Vertex> &vertices,
+                    const std::vector<uint32_t> &indices);
         ~TaraskModel();
         TaraskModel(const TaraskModel &) = delete;
         TaraskModel &operator=(const TaraskModel &) = delete;
 
+        // Vertex and index data are uploaded asynchronously, don't draw before this is true.
+        bool isReady();
         void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1,
+                  uint32_t firstInstance = 0);
 
     private:
         void createVertexBuffer(const std::vector<Vertex> &vertices);
+        void createIndexBuffer(const std::vector<uint32_t> &indices);
+        void uploadToDeviceLocal(VkBufferUsageFlags usage, const void *data, VkDeviceSize size,
+                                 VkBuffer &buffer, TaraskAllocation &allocation);
 
         TaraskDevice &taraskDevice;
         VkBuffer vertexBuffer;
-        VkDeviceMemory vertexBufferMemory;
+        TaraskAllocation vertexBufferAllocation;
         uint32_t vertexCount;
+
+        bool hasIndexBuffer = false;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        TaraskAllocation indexBufferAllocation;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        uint32_t indexCount = 0;
+
+        UploadTicket uploadTicket = 0;
+        bool uploaded = false;
     };
 
 }
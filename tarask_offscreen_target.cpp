@@ -0,0 +1,264 @@
+#include "tarask_offscreen_target.hpp"
+
+#include "tarask_trace.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskOffscreenTarget::TaraskOffscreenTarget(TaraskDevice &device, VkExtent2D extent,
+                                                 const RenderTargetSettings &settings,
+                                                 VkFormat colorFormat)
+        : m_taraskDevice{device}, m_extent{extent}, m_colorFormat{colorFormat},
+          m_framesInFlight{std::clamp(settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT)}
+    {
+        m_depthFormat = m_taraskDevice.findSupportedFormat(
+            {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+            VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        createRenderPass();
+        createImages();
+        createFramebuffers();
+        m_frameTimelineValues.assign(m_framesInFlight, 0);
+    }
+
+    TaraskOffscreenTarget::~TaraskOffscreenTarget()
+    {
+        retireImages();
+        m_taraskDevice.deletionQueue().destroyRenderPass(m_renderPass);
+    }
+
+    void TaraskOffscreenTarget::recreate(VkExtent2D extent)
+    {
+        m_extent = extent;
+        retireImages();
+        createImages();
+        createFramebuffers();
+    }
+
+    void TaraskOffscreenTarget::retireImages()
+    {
+        // the last frames rendered into these images may still be running
+        TaraskDevice &taraskDevice = m_taraskDevice;
+        m_taraskDevice.deletionQueue().enqueue(
+            [&taraskDevice, framebuffers = std::move(m_framebuffers),
+             colorImages = std::move(m_colorImages),
+             colorAllocations = std::move(m_colorAllocations),
+             colorViews = std::move(m_colorImageViews), depthImages = std::move(m_depthImages),
+             depthAllocations = std::move(m_depthAllocations),
+             depthViews = std::move(m_depthImageViews)]() mutable
+            {
+                VkDevice device = taraskDevice.device();
+                for (auto framebuffer : framebuffers)
+                {
+                    vkDestroyFramebuffer(device, framebuffer, nullptr);
+                }
+                for (size_t i = 0; i < colorImages.size(); i++)
+                {
+                    vkDestroyImageView(device, colorViews[i], nullptr);
+                    taraskDevice.destroyImage(colorImages[i], colorAllocations[i]);
+                    vkDestroyImageView(device, depthViews[i], nullptr);
+                    taraskDevice.destroyImage(depthImages[i], depthAllocations[i]);
+                }
+            });
+        m_framebuffers.clear();
+        m_colorImages.clear();
+        m_colorAllocations.clear();
+        m_colorImageViews.clear();
+        m_depthImages.clear();
+        m_depthAllocations.clear();
+        m_depthImageViews.clear();
+    }
+
+    VkResult TaraskOffscreenTarget::acquireNextImage(uint32_t *imageIndex)
+    {
+        TARASK_TRACE_SCOPE("waitFrameTimeline");
+        m_taraskDevice.graphicsTimeline().wait(m_frameTimelineValues[m_currentFrame]);
+        *imageIndex = m_currentFrame;
+        return VK_SUCCESS;
+    }
+
+    VkResult TaraskOffscreenTarget::submitCommandBuffers(const VkCommandBuffer *buffers,
+                                                         uint32_t *imageIndex)
+    {
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = buffers;
+
+        {
+            TARASK_TRACE_SCOPE("vkQueueSubmit");
+            TaraskTimeline::Wait uploadWait = m_taraskDevice.uploader().graphicsWait();
+            m_frameTimelineValues[*imageIndex] = m_taraskDevice.graphicsTimeline().submit(
+                m_taraskDevice.graphicsQueue(), submitInfo, &uploadWait, 1);
+        }
+
+        m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+        return VK_SUCCESS;
+    }
+
+    void TaraskOffscreenTarget::createRenderPass()
+    {
+        VkAttachmentDescription colorAttachment = {};
+        colorAttachment.format = m_colorFormat;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkAttachmentDescription depthAttachment{};
+        depthAttachment.format = m_depthFormat;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorAttachmentRef = {};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depthAttachmentRef{};
+        depthAttachmentRef.attachment = 1;
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+        // the previous frame in the same image may still be copied out or written to
+        std::array<VkSubpassDependency, 2> dependencies{};
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                       VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask =
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        // and the rendered image has to be complete before anyone copies it out
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
+
+        if (vkCreateRenderPass(m_taraskDevice.device(), &renderPassInfo, nullptr,
+                               &m_renderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskOffscreenTarget: failed to create render pass!");
+        }
+    }
+
+    void TaraskOffscreenTarget::createImages()
+    {
+        m_colorImages.resize(m_framesInFlight);
+        m_colorAllocations.resize(m_framesInFlight);
+        m_colorImageViews.resize(m_framesInFlight);
+        m_depthImages.resize(m_framesInFlight);
+        m_depthAllocations.resize(m_framesInFlight);
+        m_depthImageViews.resize(m_framesInFlight);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = m_extent.width;
+        imageInfo.extent.height = m_extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        for (uint32_t i = 0; i < m_framesInFlight; i++)
+        {
+            imageInfo.format = m_colorFormat;
+            imageInfo.usage =
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            m_taraskDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                               m_colorImages[i], m_colorAllocations[i]);
+            m_colorImageViews[i] =
+                createImageView(m_colorImages[i], m_colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+            imageInfo.format = m_depthFormat;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            m_taraskDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                               m_depthImages[i], m_depthAllocations[i]);
+            m_depthImageViews[i] =
+                createImageView(m_depthImages[i], m_depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+        }
+    }
+
+    VkImageView TaraskOffscreenTarget::createImageView(VkImage image, VkFormat format,
+                                                       VkImageAspectFlags aspect)
+    {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = aspect;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        VkImageView imageView;
+        if (vkCreateImageView(m_taraskDevice.device(), &viewInfo, nullptr, &imageView) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskOffscreenTarget: failed to create image view!");
+        }
+        return imageView;
+    }
+
+    void TaraskOffscreenTarget::createFramebuffers()
+    {
+        m_framebuffers.resize(imageCount());
+        for (size_t i = 0; i < imageCount(); i++)
+        {
+            std::array<VkImageView, 2> attachments = {m_colorImageViews[i], m_depthImageViews[i]};
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = m_renderPass;
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = m_extent.width;
+            framebufferInfo.height = m_extent.height;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(m_taraskDevice.device(), &framebufferInfo, nullptr,
+                                    &m_framebuffers[i]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("TaraskOffscreenTarget: failed to create framebuffer!");
+            }
+        }
+    }
+} // namespace tarask
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "tarask_device.hpp"
+#include "tarask_render_target.hpp"
+
+// std lib headers
+#include <vector>
+
+namespace tarask
+{
+    // Render target made of plain device images, used when there is no window. Images are
+    // handed out round robin, one per frame in flight, and submissions only signal the
+    // graphics timeline, so frames run as fast as the device can draw them. The present mode
+    // and image count settings have no meaning here and are ignored.
+    class TaraskOffscreenTarget : public TaraskRenderTarget
+    {
+    public:
+        TaraskOffscreenTarget(TaraskDevice &device, VkExtent2D extent,
+                              const RenderTargetSettings &settings = RenderTargetSettings{},
+                              VkFormat colorFormat = VK_FORMAT_B8G8R8A8_SRGB);
+        ~TaraskOffscreenTarget() override;
+
+        TaraskOffscreenTarget(const TaraskOffscreenTarget &) = delete;
+        TaraskOffscreenTarget &operator=(const TaraskOffscreenTarget &) = delete;
+
+        VkFramebuffer getFrameBuffer(int index) override { return m_framebuffers[index]; }
+        VkRenderPass getRenderPass() override { return m_renderPass; }
+        size_t imageCount() override { return m_colorImages.size(); }
+        uint32_t framesInFlight() override { return m_framesInFlight; }
+        VkFormat getSwapChainImageFormat() override { return m_colorFormat; }
+        VkFormat getSwapChainDepthFormat() override { return m_depthFormat; }
+        VkExtent2D getSwapChainExtent() override { return m_extent; }
+        // Finished frames are left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL for read back.
+        VkImage getImage(int index) { return m_colorImages[index]; }
+
+        // keeps the render pass, the old images go to the device deletion queue
+        void recreate(VkExtent2D extent) override;
+
+        VkResult acquireNextImage(uint32_t *imageIndex) override;
+        VkResult submitCommandBuffers(const VkCommandBuffer *buffers,
+                                      uint32_t *imageIndex) override;
+
+    private:
+        void createRenderPass();
+        void createImages();
+        void createFramebuffers();
+        void retireImages();
+        VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect);
+
+        TaraskDevice &m_taraskDevice;
+        VkExtent2D m_extent;
+        VkFormat m_colorFormat;
+        VkFormat m_depthFormat;
+        uint32_t m_framesInFlight;
+        VkRenderPass m_renderPass;
+
+        std::vector<VkImage> m_colorImages;
+        std::vector<TaraskAllocation> m_colorAllocations;
+        std::vector<VkImageView> m_colorImageViews;
+        std::vector<VkImage> m_depthImages;
+        std::vector<TaraskAllocation> m_depthAllocations;
+        std::vector<VkImageView> m_depthImageViews;
+        std::vector<VkFramebuffer> m_framebuffers;
+
+        // graphics timeline value of the last submit per image, images map one to one to
+        // frames in flight
+        std::vector<uint64_t> m_frameTimelineValues;
+        uint32_t m_currentFrame = 0;
+    };
+} // namespace tarask
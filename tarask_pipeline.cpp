@@ -20,9 +20,11 @@ namespace tarask
 
     TaraskPipeline::~TaraskPipeline()
     {
-        vkDestroyShaderModule(m_taraskDevice.device(), m_vertexShaderModule, nullptr);
-        vkDestroyShaderModule(m_taraskDevice.device(), m_fragmentShaderModule, nullptr);
-        vkDestroyPipeline(m_taraskDevice.device(), m_graphicsPipeline, nullptr);
+        // recorded frames may still be using the pipeline, swapping one out never stalls
+        TaraskDeletionQueue &deletionQueue = m_taraskDevice.deletionQueue();
+        deletionQueue.destroyShaderModule(m_vertexShaderModule);
+        deletionQueue.destroyShaderModule(m_fragmentShaderModule);
+        deletionQueue.destroyPipeline(m_graphicsPipeline);
     }
 
     std::vector<char> TaraskPipeline::readFile(const std::string &filePath)
@@ -73,8 +75,8 @@ namespace tarask
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
-        auto bindingDescriptions = TaraskModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = TaraskModel::Vertex::getAttributeDescriptions();
+        const auto &bindingDescriptions = configInfo.bindingDescriptions;
+        const auto &attributeDescriptions = configInfo.attributeDescriptions;
 
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -104,8 +106,9 @@ namespace tarask
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(m_taraskDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo,
-                                      nullptr, &m_graphicsPipeline) != VK_SUCCESS)
+        if (m_taraskDevice.pipelineCache().createGraphicsPipeline(pipelineInfo,
+                                                                  &m_graphicsPipeline) !=
+            VK_SUCCESS)
         {
             throw std::runtime_error("TaraskPipeline: Failed to create graphics pipeline.");
         }
@@ -133,6 +136,8 @@ namespace tarask
 
     void TaraskPipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo)
     {
+        configInfo.bindingDescriptions = TaraskModel::Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = TaraskModel::Vertex::getAttributeDescriptions();
 
         configInfo.inputAssemblyInfo.sType =
             VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -200,4 +205,27 @@ namespace tarask
             static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
     }
+
+    void TaraskPipeline::copyPipelineConfigInfo(const PipelineConfigInfo &src,
+                                                PipelineConfigInfo &dst)
+    {
+        dst.bindingDescriptions = src.bindingDescriptions;
+        dst.attributeDescriptions = src.attributeDescriptions;
+        dst.viewportInfo = src.viewportInfo;
+        dst.inputAssemblyInfo = src.inputAssemblyInfo;
+        dst.rasterizationInfo = src.rasterizationInfo;
+        dst.multisampleInfo = src.multisampleInfo;
+        dst.colorBlendAttachment = src.colorBlendAttachment;
+        dst.colorBlendInfo = src.colorBlendInfo;
+        dst.colorBlendInfo.pAttachments = &dst.colorBlendAttachment;
+        dst.depthStencilInfo = src.depthStencilInfo;
+        dst.dynamicStateEnables = src.dynamicStateEnables;
+        dst.dynamicStateInfo = src.dynamicStateInfo;
+        dst.dynamicStateInfo.pDynamicStates = dst.dynamicStateEnables.data();
+        dst.dynamicStateInfo.dynamicStateCount =
+            static_cast<uint32_t>(dst.dynamicStateEnables.size());
+        dst.pipelineLayout = src.pipelineLayout;
+        dst.renderPass = src.renderPass;
+        dst.subpass = src.subpass;
+    }
 } // namespace tarask
\ No newline at end of file
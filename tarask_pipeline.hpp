@@ -9,9 +9,12 @@ namespace tarask
 {
     struct PipelineConfigInfo
     {
+        PipelineConfigInfo() = default;
         PipelineConfigInfo(const PipelineConfigInfo &) = delete;
         PipelineConfigInfo &operator=(const PipelineConfigInfo &) = delete;
 
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -39,9 +42,11 @@ namespace tarask
 
         void bind(VkCommandBuffer commandBuffer);
         static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
+        // Deep copy that re-points the internal pAttachments and pDynamicStates pointers at dst.
+        static void copyPipelineConfigInfo(const PipelineConfigInfo &src, PipelineConfigInfo &dst);
+        static std::vector<char> readFile(const std::string &filePath);
 
     private:
-        static std::vector<char> readFile(const std::string &filePath);
         void createGraphicPipeline(const std::string &vertexShaderPath,
                                    const std::string &fragmentShaderPath,
                                    const PipelineConfigInfo &configInfo);
@@ -0,0 +1,279 @@
+#include "tarask_pipeline_cache.hpp"
+
+#include "tarask_device.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace tarask
+{
+    // Prepended to the driver's blob so the driver version and integrity can be checked too.
+    struct PipelineCacheFileHeader
+    {
+        char magic[4];
+        uint32_t fileVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t checksum;
+    };
+
+    // Layout of VkPipelineCacheHeaderVersionOne at the start of the driver's blob.
+    struct PipelineCacheDataHeader
+    {
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    };
+
+    static constexpr char FILE_MAGIC[4] = {'T', 'R', 'P', 'C'};
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    static uint64_t fnv1a(const char *data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    TaraskPipelineCache::TaraskPipelineCache(TaraskDevice &device, const std::string &filePath)
+        : m_taraskDevice{device}, m_filePath{filePath}
+    {
+        std::vector<char> initialData = loadFromDisk();
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+        if (vkCreatePipelineCache(m_taraskDevice.device(), &cacheInfo, nullptr,
+                                  &m_pipelineCache) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskPipelineCache: failed to create pipeline cache.");
+        }
+        m_stats.loadedFromDisk = !initialData.empty();
+        m_stats.loadedBytes = initialData.size();
+    }
+
+    TaraskPipelineCache::~TaraskPipelineCache()
+    {
+        save();
+
+        auto stats = getStats();
+        std::cout << "TaraskPipelineCache: " << stats.pipelinesCreated << " pipelines in "
+                  << stats.totalCreationMs << " ms (" << (stats.loadedFromDisk ? "warm" : "cold")
+                  << " start, " << stats.cacheHits << " hits, " << stats.cacheMisses
+                  << " misses)" << std::endl;
+
+        vkDestroyPipelineCache(m_taraskDevice.device(), m_pipelineCache, nullptr);
+    }
+
+    VkResult TaraskPipelineCache::createGraphicsPipeline(
+        const VkGraphicsPipelineCreateInfo &pipelineInfo, VkPipeline *pipeline)
+    {
+        VkPipelineCreationFeedbackEXT feedback{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        VkGraphicsPipelineCreateInfo createInfo = pipelineInfo;
+        if (m_taraskDevice.supportsPipelineCreationFeedback())
+        {
+            feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+            feedbackInfo.pNext = createInfo.pNext;
+            feedbackInfo.pPipelineCreationFeedback = &feedback;
+            createInfo.pNext = &feedbackInfo;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        VkResult result = vkCreateGraphicsPipelines(m_taraskDevice.device(), m_pipelineCache, 1,
+                                                    &createInfo, nullptr, pipeline);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        if (result == VK_SUCCESS)
+        {
+            recordCreation(feedback, elapsed.count());
+        }
+        return result;
+    }
+
+    VkResult TaraskPipelineCache::createComputePipeline(
+        const VkComputePipelineCreateInfo &pipelineInfo, VkPipeline *pipeline)
+    {
+        VkPipelineCreationFeedbackEXT feedback{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        VkComputePipelineCreateInfo createInfo = pipelineInfo;
+        if (m_taraskDevice.supportsPipelineCreationFeedback())
+        {
+            feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+            feedbackInfo.pNext = createInfo.pNext;
+            feedbackInfo.pPipelineCreationFeedback = &feedback;
+            createInfo.pNext = &feedbackInfo;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        VkResult result = vkCreateComputePipelines(m_taraskDevice.device(), m_pipelineCache, 1,
+                                                   &createInfo, nullptr, pipeline);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        if (result == VK_SUCCESS)
+        {
+            recordCreation(feedback, elapsed.count());
+        }
+        return result;
+    }
+
+    void TaraskPipelineCache::save()
+    {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(m_taraskDevice.device(), m_pipelineCache, &dataSize,
+                                   nullptr) != VK_SUCCESS ||
+            dataSize == 0)
+        {
+            return;
+        }
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(m_taraskDevice.device(), m_pipelineCache, &dataSize,
+                                   data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+        data.resize(dataSize);
+
+        const auto &properties = m_taraskDevice.properties;
+        PipelineCacheFileHeader header{};
+        memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.fileVersion = FILE_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.dataSize = data.size();
+        header.checksum = fnv1a(data.data(), data.size());
+
+        // write next to the real file and rename over it, which is atomic on POSIX
+        std::string tempPath = m_filePath + ".tmp";
+        {
+            std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+            if (!file.is_open())
+            {
+                std::cerr << "TaraskPipelineCache: failed to open " << tempPath << std::endl;
+                return;
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(data.data(), data.size());
+            if (!file.good())
+            {
+                std::cerr << "TaraskPipelineCache: failed to write " << tempPath << std::endl;
+                file.close();
+                std::remove(tempPath.c_str());
+                return;
+            }
+        }
+#ifdef _WIN32
+        std::remove(m_filePath.c_str());
+#endif
+        if (std::rename(tempPath.c_str(), m_filePath.c_str()) != 0)
+        {
+            std::cerr << "TaraskPipelineCache: failed to replace " << m_filePath << std::endl;
+            std::remove(tempPath.c_str());
+        }
+    }
+
+    PipelineCacheStats TaraskPipelineCache::getStats()
+    {
+        std::lock_guard<std::mutex> lock{m_statsMutex};
+        return m_stats;
+    }
+
+    std::vector<char> TaraskPipelineCache::loadFromDisk()
+    {
+        std::ifstream file{m_filePath, std::ios::ate | std::ios::binary};
+        if (!file.is_open())
+        {
+            return {};
+        }
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize < sizeof(PipelineCacheFileHeader))
+        {
+            return {};
+        }
+
+        PipelineCacheFileHeader header;
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+            header.fileVersion != FILE_VERSION ||
+            header.dataSize != fileSize - sizeof(PipelineCacheFileHeader))
+        {
+            std::cout << "TaraskPipelineCache: ignoring malformed cache file." << std::endl;
+            return {};
+        }
+
+        const auto &properties = m_taraskDevice.properties;
+        if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+            header.driverVersion != properties.driverVersion ||
+            memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            std::cout << "TaraskPipelineCache: cache was built for another device or driver."
+                      << std::endl;
+            return {};
+        }
+
+        std::vector<char> data(static_cast<size_t>(header.dataSize));
+        file.read(data.data(), data.size());
+        if (!file.good() || fnv1a(data.data(), data.size()) != header.checksum ||
+            !isCompatible(data))
+        {
+            std::cout << "TaraskPipelineCache: ignoring corrupted cache file." << std::endl;
+            return {};
+        }
+        return data;
+    }
+
+    bool TaraskPipelineCache::isCompatible(const std::vector<char> &data)
+    {
+        if (data.size() < sizeof(PipelineCacheDataHeader))
+        {
+            return false;
+        }
+        PipelineCacheDataHeader header;
+        memcpy(&header, data.data(), sizeof(header));
+
+        const auto &properties = m_taraskDevice.properties;
+        return header.headerSize >= sizeof(PipelineCacheDataHeader) &&
+               header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+               memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void TaraskPipelineCache::recordCreation(const VkPipelineCreationFeedbackEXT &feedback,
+                                             double milliseconds)
+    {
+        std::lock_guard<std::mutex> lock{m_statsMutex};
+        m_stats.pipelinesCreated++;
+        m_stats.totalCreationMs += milliseconds;
+        if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)
+        {
+            if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+            {
+                m_stats.cacheHits++;
+            }
+            else
+            {
+                m_stats.cacheMisses++;
+            }
+        }
+    }
+} // namespace tarask
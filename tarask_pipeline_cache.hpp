@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tarask
+{
+    class TaraskDevice;
+
+    struct PipelineCacheStats
+    {
+        bool loadedFromDisk = false;
+        size_t loadedBytes = 0;
+        uint32_t pipelinesCreated = 0;
+        // only known when VK_EXT_pipeline_creation_feedback is available
+        uint32_t cacheHits = 0;
+        uint32_t cacheMisses = 0;
+        double totalCreationMs = 0.0;
+    };
+
+    // Device owned VkPipelineCache persisted to disk between runs. The blob is only reused
+    // when its header matches the current vendor, device, driver and cache UUID, and it is
+    // written through a temporary file so a crash never leaves a truncated cache behind.
+    class TaraskPipelineCache
+    {
+    public:
+        TaraskPipelineCache(TaraskDevice &device, const std::string &filePath);
+        ~TaraskPipelineCache();
+
+        TaraskPipelineCache(const TaraskPipelineCache &) = delete;
+        TaraskPipelineCache &operator=(const TaraskPipelineCache &) = delete;
+
+        VkPipelineCache cache() { return m_pipelineCache; }
+
+        VkResult createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &pipelineInfo,
+                                        VkPipeline *pipeline);
+        VkResult createComputePipeline(const VkComputePipelineCreateInfo &pipelineInfo,
+                                       VkPipeline *pipeline);
+        void save();
+
+        PipelineCacheStats getStats();
+
+    private:
+        std::vector<char> loadFromDisk();
+        bool isCompatible(const std::vector<char> &data);
+        void recordCreation(const VkPipelineCreationFeedbackEXT &feedback, double milliseconds);
+
+        TaraskDevice &m_taraskDevice;
+        std::string m_filePath;
+        VkPipelineCache m_pipelineCache;
+        PipelineCacheStats m_stats;
+        std::mutex m_statsMutex;
+    };
+} // namespace tarask
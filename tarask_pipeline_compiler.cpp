@@ -0,0 +1,123 @@
+#include "tarask_pipeline_compiler.hpp"
+
+#include "tarask_trace.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+namespace tarask
+{
+    enum class PipelineBuildStatus
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    struct PipelineBuildState
+    {
+        std::atomic<PipelineBuildStatus> status{PipelineBuildStatus::Pending};
+        std::unique_ptr<TaraskPipeline> pipeline;
+        std::string error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    bool TaraskPipelineHandle::isReady() const
+    {
+        return m_state != nullptr && m_state->status.load() == PipelineBuildStatus::Ready;
+    }
+
+    bool TaraskPipelineHandle::isPending() const
+    {
+        return m_state != nullptr && m_state->status.load() == PipelineBuildStatus::Pending;
+    }
+
+    TaraskPipeline *TaraskPipelineHandle::get() const
+    {
+        if (m_state == nullptr)
+        {
+            return nullptr;
+        }
+        switch (m_state->status.load())
+        {
+        case PipelineBuildStatus::Ready:
+            return m_state->pipeline.get();
+        case PipelineBuildStatus::Failed:
+            throw std::runtime_error(m_state->error);
+        default:
+            return nullptr;
+        }
+    }
+
+    TaraskPipeline *TaraskPipelineHandle::wait() const
+    {
+        if (m_state == nullptr)
+        {
+            return nullptr;
+        }
+        std::unique_lock<std::mutex> lock{m_state->mutex};
+        m_state->finished.wait(
+            lock, [this] { return m_state->status.load() != PipelineBuildStatus::Pending; });
+        lock.unlock();
+        return get();
+    }
+
+    TaraskPipelineCompiler::TaraskPipelineCompiler(TaraskDevice &device, TaraskJobSystem &jobs)
+        : m_taraskDevice{device}, m_jobs{jobs}
+    {
+    }
+
+    TaraskPipelineCompiler::~TaraskPipelineCompiler()
+    {
+        m_jobs.wait(m_pending);
+    }
+
+    TaraskPipelineHandle TaraskPipelineCompiler::compile(const std::string &vertexShaderPath,
+                                                         const std::string &fragmentShaderPath,
+                                                         const PipelineConfigInfo &configInfo)
+    {
+        auto job = std::make_shared<Job>();
+        job->vertexShaderPath = vertexShaderPath;
+        job->fragmentShaderPath = fragmentShaderPath;
+        TaraskPipeline::copyPipelineConfigInfo(configInfo, job->configInfo);
+        job->state = std::make_shared<PipelineBuildState>();
+
+        TaraskPipelineHandle handle{job->state};
+        m_jobs.run([this, job](uint32_t) { build(*job); }, &m_pending, JobPriority::Background);
+        return handle;
+    }
+
+    TaraskPipelineHandle TaraskPipelineCompiler::makeReady(std::unique_ptr<TaraskPipeline> pipeline)
+    {
+        auto state = std::make_shared<PipelineBuildState>();
+        state->pipeline = std::move(pipeline);
+        state->status = PipelineBuildStatus::Ready;
+        return TaraskPipelineHandle{state};
+    }
+
+    void TaraskPipelineCompiler::build(Job &job)
+    {
+        TARASK_TRACE_SCOPE("compilePipeline");
+        PipelineBuildStatus status = PipelineBuildStatus::Ready;
+        try
+        {
+            job.state->pipeline = std::make_unique<TaraskPipeline>(
+                m_taraskDevice, job.vertexShaderPath, job.fragmentShaderPath, job.configInfo);
+        }
+        catch (const std::exception &e)
+        {
+            job.state->error = e.what();
+            status = PipelineBuildStatus::Failed;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{job.state->mutex};
+            job.state->status = status;
+        }
+        job.state->finished.notify_all();
+    }
+} // namespace tarask
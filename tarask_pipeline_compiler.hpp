@@ -0,0 +1,73 @@
+#pragma once
+
+#include "tarask_device.hpp"
+#include "tarask_job_system.hpp"
+#include "tarask_pipeline.hpp"
+
+// std lib headers
+#include <memory>
+#include <string>
+
+namespace tarask
+{
+    struct PipelineBuildState;
+
+    // Future-like reference to a pipeline that may still be compiling on a worker thread.
+    class TaraskPipelineHandle
+    {
+    public:
+        TaraskPipelineHandle() = default;
+
+        bool isValid() const { return m_state != nullptr; }
+        bool isReady() const;
+        bool isPending() const;
+        // Returns nullptr while the pipeline is still compiling, throws if compilation failed.
+        TaraskPipeline *get() const;
+        // Blocks until compilation finished, then behaves like get().
+        TaraskPipeline *wait() const;
+
+    private:
+        friend class TaraskPipelineCompiler;
+        explicit TaraskPipelineHandle(std::shared_ptr<PipelineBuildState> state)
+            : m_state{std::move(state)}
+        {
+        }
+
+        std::shared_ptr<PipelineBuildState> m_state;
+    };
+
+    // Builds graphics pipelines as background jobs, so they only ever take idle workers and
+    // never stall a frame waiting on its own jobs. All builds go through the device's pipeline
+    // cache, which Vulkan synchronizes internally.
+    class TaraskPipelineCompiler
+    {
+    public:
+        TaraskPipelineCompiler(TaraskDevice &device, TaraskJobSystem &jobs);
+        // waits for the builds still pending
+        ~TaraskPipelineCompiler();
+
+        TaraskPipelineCompiler(const TaraskPipelineCompiler &) = delete;
+        TaraskPipelineCompiler &operator=(const TaraskPipelineCompiler &) = delete;
+
+        TaraskPipelineHandle compile(const std::string &vertexShaderPath,
+                                     const std::string &fragmentShaderPath,
+                                     const PipelineConfigInfo &configInfo);
+        // Wraps an already built pipeline so sync and async callers share one handle type.
+        static TaraskPipelineHandle makeReady(std::unique_ptr<TaraskPipeline> pipeline);
+
+    private:
+        struct Job
+        {
+            std::string vertexShaderPath;
+            std::string fragmentShaderPath;
+            PipelineConfigInfo configInfo;
+            std::shared_ptr<PipelineBuildState> state;
+        };
+
+        void build(Job &job);
+
+        TaraskDevice &m_taraskDevice;
+        TaraskJobSystem &m_jobs;
+        TaraskJobCounter m_pending;
+    };
+} // namespace tarask
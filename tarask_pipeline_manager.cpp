@@ -0,0 +1,188 @@
+#include "tarask_pipeline_manager.hpp"
+
+#include "tarask_utils.hpp"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+namespace tarask
+{
+    namespace
+    {
+        // flattens state fields into key words, floats by their bits
+        void appendState(std::vector<uint64_t> &) {}
+
+        template <typename T, typename... Rest>
+        void appendState(std::vector<uint64_t> &state, const T &value, const Rest &...rest)
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                uint32_t bits;
+                static_assert(sizeof(T) == sizeof(bits));
+                std::memcpy(&bits, &value, sizeof(bits));
+                state.push_back(bits);
+            }
+            else
+            {
+                state.push_back(static_cast<uint64_t>(value));
+            }
+            appendState(state, rest...);
+        }
+    } // namespace
+
+    TaraskPipelineManager::TaraskPipelineManager(TaraskDevice &device, TaraskJobSystem &jobs)
+        : m_taraskDevice{device}, m_compiler{device, jobs}
+    {
+    }
+
+    TaraskPipeline &TaraskPipelineManager::getPipeline(const std::string &vertexShaderPath,
+                                                       const std::string &fragmentShaderPath,
+                                                       const PipelineConfigInfo &configInfo,
+                                                       const RenderPassCompatibility &compatibility)
+    {
+        TaraskPipelineKey key{vertexShaderPath, fragmentShaderPath, configInfo, compatibility};
+        auto it = m_pipelines.find(key);
+        if (it != m_pipelines.end())
+        {
+            return *it->second.wait();
+        }
+
+        std::cout << "TaraskPipelineManager: building pipeline for " << vertexShaderPath << " / "
+                  << fragmentShaderPath << std::endl;
+        auto pipeline = std::make_unique<TaraskPipeline>(m_taraskDevice, vertexShaderPath,
+                                                         fragmentShaderPath, configInfo);
+        auto handle = TaraskPipelineCompiler::makeReady(std::move(pipeline));
+        return *m_pipelines.emplace(std::move(key), handle).first->second.get();
+    }
+
+    TaraskPipelineHandle TaraskPipelineManager::getPipelineAsync(
+        const std::string &vertexShaderPath, const std::string &fragmentShaderPath,
+        const PipelineConfigInfo &configInfo, const RenderPassCompatibility &compatibility)
+    {
+        TaraskPipelineKey key{vertexShaderPath, fragmentShaderPath, configInfo, compatibility};
+        auto it = m_pipelines.find(key);
+        if (it != m_pipelines.end())
+        {
+            return it->second;
+        }
+
+        std::cout << "TaraskPipelineManager: compiling pipeline for " << vertexShaderPath
+                  << " / " << fragmentShaderPath << " in the background" << std::endl;
+        auto handle = m_compiler.compile(vertexShaderPath, fragmentShaderPath, configInfo);
+        m_pipelines.emplace(std::move(key), handle);
+        return handle;
+    }
+
+    void TaraskPipelineManager::waitIdle()
+    {
+        for (auto &entry : m_pipelines)
+        {
+            if (entry.second.isPending())
+            {
+                // failures surface through get() at the call site, not here
+                try
+                {
+                    entry.second.wait();
+                }
+                catch (const std::exception &)
+                {
+                }
+            }
+        }
+    }
+
+    void TaraskPipelineManager::clear()
+    {
+        waitIdle();
+        m_pipelines.clear();
+    }
+
+    size_t TaraskPipelineManager::hashPipelineConfig(const std::string &vertexShaderPath,
+                                                     const std::string &fragmentShaderPath,
+                                                     const PipelineConfigInfo &configInfo,
+                                                     const RenderPassCompatibility &compatibility)
+    {
+        return TaraskPipelineKey::Hash{}(
+            TaraskPipelineKey{vertexShaderPath, fragmentShaderPath, configInfo, compatibility});
+    }
+
+    TaraskPipelineKey::TaraskPipelineKey(const std::string &vertexShaderPath,
+                                         const std::string &fragmentShaderPath,
+                                         const PipelineConfigInfo &configInfo,
+                                         const RenderPassCompatibility &compatibility)
+        : vertexShaderPath{vertexShaderPath},
+          fragmentShaderPath{fragmentShaderPath},
+          pipelineLayout{configInfo.pipelineLayout},
+          compatibility{compatibility}
+    {
+        // the counts keep differently sized arrays from lining up
+        appendState(state, configInfo.bindingDescriptions.size());
+        for (const auto &binding : configInfo.bindingDescriptions)
+        {
+            appendState(state, binding.binding, binding.stride, binding.inputRate);
+        }
+        appendState(state, configInfo.attributeDescriptions.size());
+        for (const auto &attribute : configInfo.attributeDescriptions)
+        {
+            appendState(state, attribute.location, attribute.binding, attribute.format,
+                        attribute.offset);
+        }
+
+        const auto &inputAssembly = configInfo.inputAssemblyInfo;
+        appendState(state, inputAssembly.topology, inputAssembly.primitiveRestartEnable);
+
+        const auto &rasterization = configInfo.rasterizationInfo;
+        appendState(state, rasterization.depthClampEnable, rasterization.rasterizerDiscardEnable,
+                    rasterization.polygonMode, rasterization.cullMode, rasterization.frontFace,
+                    rasterization.depthBiasEnable, rasterization.depthBiasConstantFactor,
+                    rasterization.depthBiasClamp, rasterization.depthBiasSlopeFactor,
+                    rasterization.lineWidth);
+
+        const auto &multisample = configInfo.multisampleInfo;
+        appendState(state, multisample.rasterizationSamples, multisample.sampleShadingEnable,
+                    multisample.minSampleShading, multisample.alphaToCoverageEnable,
+                    multisample.alphaToOneEnable);
+
+        const auto &blendAttachment = configInfo.colorBlendAttachment;
+        appendState(state, blendAttachment.blendEnable, blendAttachment.srcColorBlendFactor,
+                    blendAttachment.dstColorBlendFactor, blendAttachment.colorBlendOp,
+                    blendAttachment.srcAlphaBlendFactor, blendAttachment.dstAlphaBlendFactor,
+                    blendAttachment.alphaBlendOp, blendAttachment.colorWriteMask);
+
+        const auto &colorBlend = configInfo.colorBlendInfo;
+        appendState(state, colorBlend.logicOpEnable, colorBlend.logicOp,
+                    colorBlend.attachmentCount, colorBlend.blendConstants[0],
+                    colorBlend.blendConstants[1], colorBlend.blendConstants[2],
+                    colorBlend.blendConstants[3]);
+
+        const auto &depthStencil = configInfo.depthStencilInfo;
+        appendState(state, depthStencil.depthTestEnable, depthStencil.depthWriteEnable,
+                    depthStencil.depthCompareOp, depthStencil.depthBoundsTestEnable,
+                    depthStencil.stencilTestEnable, depthStencil.minDepthBounds,
+                    depthStencil.maxDepthBounds);
+
+        appendState(state, configInfo.dynamicStateEnables.size());
+        for (auto dynamicState : configInfo.dynamicStateEnables)
+        {
+            appendState(state, dynamicState);
+        }
+
+        appendState(state, configInfo.subpass);
+    }
+
+    size_t TaraskPipelineKey::Hash::operator()(const TaraskPipelineKey &key) const
+    {
+        size_t seed = 0;
+        hashCombine(seed, key.vertexShaderPath, key.fragmentShaderPath, key.pipelineLayout,
+                    key.compatibility.colorFormat, key.compatibility.depthFormat,
+                    key.compatibility.samples);
+        for (uint64_t word : key.state)
+        {
+            hashCombine(seed, word);
+        }
+        return seed;
+    }
+} // namespace tarask
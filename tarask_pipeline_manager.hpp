@@ -0,0 +1,100 @@
+#pragma once
+
+#include "tarask_device.hpp"
+#include "tarask_pipeline.hpp"
+#include "tarask_pipeline_compiler.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tarask
+{
+    // Pipelines only depend on the render pass through its attachment formats and sample
+    // counts, so any two render passes with the same description here can share pipelines.
+    struct RenderPassCompatibility
+    {
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+        bool operator==(const RenderPassCompatibility &other) const
+        {
+            return colorFormat == other.colorFormat && depthFormat == other.depthFormat &&
+                   samples == other.samples;
+        }
+    };
+
+    // Everything a cached pipeline was built from. Lookups compare all of it, the hash only
+    // picks the bucket. configInfo.renderPass is left out, compatibility stands in for it.
+    struct TaraskPipelineKey
+    {
+        TaraskPipelineKey(const std::string &vertexShaderPath,
+                          const std::string &fragmentShaderPath,
+                          const PipelineConfigInfo &configInfo,
+                          const RenderPassCompatibility &compatibility);
+
+        bool operator==(const TaraskPipelineKey &other) const
+        {
+            return vertexShaderPath == other.vertexShaderPath &&
+                   fragmentShaderPath == other.fragmentShaderPath && state == other.state &&
+                   pipelineLayout == other.pipelineLayout &&
+                   compatibility == other.compatibility;
+        }
+
+        struct Hash
+        {
+            size_t operator()(const TaraskPipelineKey &key) const;
+        };
+
+        std::string vertexShaderPath;
+        std::string fragmentShaderPath;
+        // the vertex input and fixed function state, one word per field
+        std::vector<uint64_t> state;
+        VkPipelineLayout pipelineLayout;
+        RenderPassCompatibility compatibility;
+    };
+
+    // Caches pipelines by their shaders, fixed function state and render pass
+    // compatibility. Looking up an existing pipeline is cheap, so callers can ask for their
+    // pipeline again after every swap chain recreation and only pay for a build when the
+    // attachment formats really changed. getPipelineAsync hands new builds to the job system
+    // instead, so the frame loop keeps running while a pipeline compiles.
+    class TaraskPipelineManager
+    {
+    public:
+        TaraskPipelineManager(TaraskDevice &device, TaraskJobSystem &jobs);
+
+        TaraskPipelineManager(const TaraskPipelineManager &) = delete;
+        TaraskPipelineManager &operator=(const TaraskPipelineManager &) = delete;
+
+        TaraskPipeline &getPipeline(const std::string &vertexShaderPath,
+                                    const std::string &fragmentShaderPath,
+                                    const PipelineConfigInfo &configInfo,
+                                    const RenderPassCompatibility &compatibility);
+        TaraskPipelineHandle getPipelineAsync(const std::string &vertexShaderPath,
+                                              const std::string &fragmentShaderPath,
+                                              const PipelineConfigInfo &configInfo,
+                                              const RenderPassCompatibility &compatibility);
+        // Blocks until no build is pending. Call it before destroying a render pass or
+        // pipeline layout that a pending build may still reference.
+        void waitIdle();
+        void clear();
+        size_t pipelineCount() { return m_pipelines.size(); }
+
+        static size_t hashPipelineConfig(const std::string &vertexShaderPath,
+                                         const std::string &fragmentShaderPath,
+                                         const PipelineConfigInfo &configInfo,
+                                         const RenderPassCompatibility &compatibility);
+
+    private:
+        TaraskDevice &m_taraskDevice;
+        std::unordered_map<TaraskPipelineKey, TaraskPipelineHandle, TaraskPipelineKey::Hash>
+            m_pipelines;
+        // declared last so its pending builds finish before anything else goes away
+        TaraskPipelineCompiler m_compiler;
+    };
+} // namespace tarask
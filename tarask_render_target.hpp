@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstddef>
+#include <cstdint>
+
+namespace tarask
+{
+    struct RenderTargetSettings
+    {
+        // frames the CPU may record ahead of the GPU, clamped to 1..MAX_FRAMES_IN_FLIGHT
+        uint32_t framesInFlight = 2;
+        // swap chain only, falls back to FIFO, the one mode every surface supports
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        // swap chain only, 0 asks for one more than the surface minimum, otherwise clamped
+        // to what the surface allows
+        uint32_t imageCount = 0;
+    };
+
+    // What FirstApp needs from the images it renders into. TaraskSwapChain presents them to
+    // a window, TaraskOffscreenTarget keeps them on the device for headless runs.
+    class TaraskRenderTarget
+    {
+    public:
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+        virtual ~TaraskRenderTarget() = default;
+
+        virtual VkFramebuffer getFrameBuffer(int index) = 0;
+        virtual VkRenderPass getRenderPass() = 0;
+        virtual size_t imageCount() = 0;
+        virtual uint32_t framesInFlight() = 0;
+        virtual VkFormat getSwapChainImageFormat() = 0;
+        virtual VkFormat getSwapChainDepthFormat() = 0;
+        virtual VkExtent2D getSwapChainExtent() = 0;
+
+        // Rebuilds the extent dependent resources without waiting for the device to go idle,
+        // what frames in flight still use is released through the deletion queue.
+        virtual void recreate(VkExtent2D extent) = 0;
+
+        virtual VkResult acquireNextImage(uint32_t *imageIndex) = 0;
+        virtual VkResult submitCommandBuffers(const VkCommandBuffer *buffers,
+                                              uint32_t *imageIndex) = 0;
+    };
+} // namespace tarask
@@ -0,0 +1,183 @@
+#include "tarask_scene.hpp"
+
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TARASK_SCENE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace tarask
+{
+    uint32_t TaraskScene::addMesh(const TaraskMesh &mesh)
+    {
+        m_meshes.push_back(mesh);
+        return static_cast<uint32_t>(m_meshes.size() - 1);
+    }
+
+    void TaraskScene::reserve(uint32_t objectCount)
+    {
+        m_slots.reserve(objectCount);
+        for (auto *component : {&m_originX, &m_originY, &m_velocityX, &m_velocityY,
+                                &m_positionX, &m_positionY, &m_colorR, &m_colorG, &m_colorB})
+        {
+            component->reserve(objectCount);
+        }
+        m_meshIds.reserve(objectCount);
+        m_slotOf.reserve(objectCount);
+    }
+
+    TaraskObjectHandle TaraskScene::create(uint32_t meshId, glm::vec2 origin, glm::vec2 velocity,
+                                           glm::vec3 color)
+    {
+        if (meshId >= m_meshes.size())
+        {
+            throw std::runtime_error("TaraskScene: unknown mesh.");
+        }
+
+        uint32_t slotIndex = m_freeSlot;
+        if (slotIndex == UINT32_MAX)
+        {
+            slotIndex = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({0, 0});
+        }
+        else
+        {
+            m_freeSlot = m_slots[slotIndex].index;
+        }
+        Slot &slot = m_slots[slotIndex];
+        slot.index = objectCount();
+
+        m_originX.push_back(origin.x);
+        m_originY.push_back(origin.y);
+        m_velocityX.push_back(velocity.x);
+        m_velocityY.push_back(velocity.y);
+        m_positionX.push_back(origin.x);
+        m_positionY.push_back(origin.y);
+        m_colorR.push_back(color.x);
+        m_colorG.push_back(color.y);
+        m_colorB.push_back(color.z);
+        m_meshIds.push_back(meshId);
+        m_slotOf.push_back(slotIndex);
+        return {slotIndex, slot.generation};
+    }
+
+    void TaraskScene::destroy(TaraskObjectHandle handle)
+    {
+        uint32_t index = checkedIndex(handle);
+        uint32_t last = objectCount() - 1;
+        if (index != last)
+        {
+            m_originX[index] = m_originX[last];
+            m_originY[index] = m_originY[last];
+            m_velocityX[index] = m_velocityX[last];
+            m_velocityY[index] = m_velocityY[last];
+            m_positionX[index] = m_positionX[last];
+            m_positionY[index] = m_positionY[last];
+            m_colorR[index] = m_colorR[last];
+            m_colorG[index] = m_colorG[last];
+            m_colorB[index] = m_colorB[last];
+            m_meshIds[index] = m_meshIds[last];
+            m_slotOf[index] = m_slotOf[last];
+            m_slots[m_slotOf[index]].index = index;
+        }
+        for (auto *component : {&m_originX, &m_originY, &m_velocityX, &m_velocityY,
+                                &m_positionX, &m_positionY, &m_colorR, &m_colorG, &m_colorB})
+        {
+            component->pop_back();
+        }
+        m_meshIds.pop_back();
+        m_slotOf.pop_back();
+
+        Slot &slot = m_slots[handle.index];
+        slot.generation++;
+        slot.index = m_freeSlot;
+        m_freeSlot = handle.index;
+    }
+
+    bool TaraskScene::isAlive(TaraskObjectHandle handle) const
+    {
+        // destroying bumps the generation, so only the live object's handles still match
+        return handle.index < m_slots.size() &&
+               m_slots[handle.index].generation == handle.generation;
+    }
+
+    uint32_t TaraskScene::checkedIndex(TaraskObjectHandle handle) const
+    {
+        if (!isAlive(handle))
+        {
+            throw std::runtime_error("TaraskScene: stale object handle.");
+        }
+        return m_slots[handle.index].index;
+    }
+
+    uint32_t TaraskScene::denseIndex(TaraskObjectHandle handle) const
+    {
+        return checkedIndex(handle);
+    }
+
+    void TaraskScene::setOrigin(TaraskObjectHandle handle, glm::vec2 origin)
+    {
+        uint32_t index = checkedIndex(handle);
+        m_originX[index] = origin.x;
+        m_originY[index] = origin.y;
+    }
+
+    void TaraskScene::setVelocity(TaraskObjectHandle handle, glm::vec2 velocity)
+    {
+        uint32_t index = checkedIndex(handle);
+        m_velocityX[index] = velocity.x;
+        m_velocityY[index] = velocity.y;
+    }
+
+    void TaraskScene::setColor(TaraskObjectHandle handle, glm::vec3 color)
+    {
+        uint32_t index = checkedIndex(handle);
+        m_colorR[index] = color.x;
+        m_colorG[index] = color.y;
+        m_colorB[index] = color.z;
+    }
+
+    glm::vec2 TaraskScene::position(TaraskObjectHandle handle) const
+    {
+        return positionAt(checkedIndex(handle));
+    }
+
+    void TaraskScene::animate(uint32_t first, uint32_t count, float time)
+    {
+        const float *originX = m_originX.data() + first;
+        const float *originY = m_originY.data() + first;
+        const float *velocityX = m_velocityX.data() + first;
+        const float *velocityY = m_velocityY.data() + first;
+        float *positionX = m_positionX.data() + first;
+        float *positionY = m_positionY.data() + first;
+
+        uint32_t i = 0;
+#ifdef TARASK_SCENE_SSE
+        // four objects per step, the arrays need no particular alignment
+        const __m128 t = _mm_set1_ps(time);
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(positionX + i, _mm_add_ps(_mm_loadu_ps(originX + i),
+                                                    _mm_mul_ps(_mm_loadu_ps(velocityX + i), t)));
+            _mm_storeu_ps(positionY + i, _mm_add_ps(_mm_loadu_ps(originY + i),
+                                                    _mm_mul_ps(_mm_loadu_ps(velocityY + i), t)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            positionX[i] = originX[i] + velocityX[i] * time;
+            positionY[i] = originY[i] + velocityY[i] * time;
+        }
+    }
+
+    void TaraskScene::writeObjects(TaraskObjectData *out, uint32_t first, uint32_t count) const
+    {
+        // sequential writes only, mapped memory may be write combined
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            out[i].offset = {m_positionX[i], m_positionY[i]};
+            out[i].color = {m_colorR[i], m_colorG[i], m_colorB[i]};
+        }
+    }
+} // namespace tarask
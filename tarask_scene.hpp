@@ -0,0 +1,111 @@
+#pragma once
+
+#include "tarask_geometry_arena.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <vector>
+
+namespace tarask
+{
+    // One object as the shaders read it from a storage buffer, laid out to match the std430
+    // ObjectData struct in simple_instanced.vert.
+    struct TaraskObjectData
+    {
+        glm::vec2 offset;
+        alignas(16) glm::vec3 color;
+    };
+
+    // Stable reference to a scene object. The index picks a slot that survives other objects
+    // being destroyed, the generation tells a handle to a destroyed object from one to
+    // whatever reused its slot.
+    struct TaraskObjectHandle
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool operator==(const TaraskObjectHandle &other) const
+        {
+            return index == other.index && generation == other.generation;
+        }
+        bool operator!=(const TaraskObjectHandle &other) const { return !(*this == other); }
+    };
+
+    // Scene objects stored as a structure of arrays: every component is its own tightly
+    // packed array and objects stay dense, destroying one moves the last into its place. The
+    // kernels below stream over plain float arrays, so they vectorize and any disjoint ranges
+    // of [0, objectCount()) can be processed by different threads.
+    //
+    // An object's position is origin + velocity * time, recomputed by animate() each frame
+    // from the shared clock, so frames never accumulate drift and ranges need no ordering.
+    class TaraskScene
+    {
+    public:
+        TaraskScene() = default;
+
+        TaraskScene(const TaraskScene &) = delete;
+        TaraskScene &operator=(const TaraskScene &) = delete;
+
+        // meshes are referenced by id, objects only store that
+        uint32_t addMesh(const TaraskMesh &mesh);
+        const TaraskMesh &mesh(uint32_t meshId) const { return m_meshes[meshId]; }
+
+        void reserve(uint32_t objectCount);
+        TaraskObjectHandle create(uint32_t meshId, glm::vec2 origin, glm::vec2 velocity,
+                                  glm::vec3 color);
+        // The last object takes the freed dense index, handles to it stay valid.
+        void destroy(TaraskObjectHandle handle);
+        bool isAlive(TaraskObjectHandle handle) const;
+
+        void setOrigin(TaraskObjectHandle handle, glm::vec2 origin);
+        void setVelocity(TaraskObjectHandle handle, glm::vec2 velocity);
+        void setColor(TaraskObjectHandle handle, glm::vec3 color);
+        // as of the last animate()
+        glm::vec2 position(TaraskObjectHandle handle) const;
+
+        uint32_t objectCount() const { return static_cast<uint32_t>(m_meshIds.size()); }
+        // dense index of a live object, where its data is written
+        uint32_t denseIndex(TaraskObjectHandle handle) const;
+        uint32_t meshIdAt(uint32_t index) const { return m_meshIds[index]; }
+        glm::vec2 positionAt(uint32_t index) const
+        {
+            return {m_positionX[index], m_positionY[index]};
+        }
+
+        // kernels over the dense objects [first, first + count)
+
+        // positions at time, in the same units as the velocities
+        void animate(uint32_t first, uint32_t count, float time);
+        // Writes one entry per object to out[first] onwards, out may be mapped memory.
+        void writeObjects(TaraskObjectData *out, uint32_t first, uint32_t count) const;
+
+    private:
+        struct Slot
+        {
+            // into the component arrays while alive, next free slot otherwise
+            uint32_t index;
+            uint32_t generation;
+        };
+
+        uint32_t checkedIndex(TaraskObjectHandle handle) const;
+
+        std::vector<TaraskMesh> m_meshes;
+
+        std::vector<Slot> m_slots;
+        uint32_t m_freeSlot = UINT32_MAX;
+
+        // components, all indexed by dense index
+        std::vector<float> m_originX;
+        std::vector<float> m_originY;
+        std::vector<float> m_velocityX;
+        std::vector<float> m_velocityY;
+        std::vector<float> m_positionX;
+        std::vector<float> m_positionY;
+        std::vector<float> m_colorR;
+        std::vector<float> m_colorG;
+        std::vector<float> m_colorB;
+        std::vector<uint32_t> m_meshIds;
+        // back to the slot, to fix it up when an object moves
+        std::vector<uint32_t> m_slotOf;
+    };
+} // namespace tarask
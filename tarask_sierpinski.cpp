@@ -0,0 +1,356 @@
+#include "tarask_sierpinski.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TARASK_SIERPINSKI_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace tarask
+{
+    namespace
+    {
+        // below this many leaves the threads cost more than they save
+        constexpr size_t MIN_LEAVES_PER_THREAD = 3 * 3 * 3 * 3 * 3 * 3;
+
+        struct Triangle
+        {
+            glm::vec2 left;
+            glm::vec2 right;
+            glm::vec2 top;
+        };
+
+        inline void writeLeaf(TaraskModel::Vertex *out, glm::vec2 left, glm::vec2 right,
+                              glm::vec2 top)
+        {
+            out[0] = {top, {1.0f, 0.0f, 0.0f}};
+            out[1] = {right, {0.0f, 1.0f, 0.0f}};
+            out[2] = {left, {0.0f, 0.0f, 1.0f}};
+        }
+
+        // Returns the pointer past the last vertex written.
+        TaraskModel::Vertex *subdivideScalar(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                             glm::vec2 right, glm::vec2 top)
+        {
+            if (depth <= 0)
+            {
+                writeLeaf(out, left, right, top);
+                return out + 3;
+            }
+            auto leftTop = 0.5f * (left + top);
+            auto rightTop = 0.5f * (right + top);
+            auto leftRight = 0.5f * (left + right);
+            out = subdivideScalar(out, depth - 1, left, leftRight, leftTop);
+            out = subdivideScalar(out, depth - 1, leftRight, right, rightTop);
+            return subdivideScalar(out, depth - 1, leftTop, rightTop, top);
+        }
+
+#ifdef TARASK_SIERPINSKI_SSE
+        // The triangle lives in two registers, leftRight = (left, right) and topTop =
+        // (top, top), so all three midpoints come out of two adds and two multiplies.
+        TaraskModel::Vertex *subdivideSse(TaraskModel::Vertex *out, int depth, __m128 leftRight,
+                                          __m128 topTop)
+        {
+            if (depth <= 0)
+            {
+                const glm::vec3 colors[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+                _mm_storel_pi(reinterpret_cast<__m64 *>(&out[0].position), topTop);
+                _mm_storeh_pi(reinterpret_cast<__m64 *>(&out[1].position), leftRight);
+                _mm_storel_pi(reinterpret_cast<__m64 *>(&out[2].position), leftRight);
+                out[0].color = colors[0];
+                out[1].color = colors[1];
+                out[2].color = colors[2];
+                return out + 3;
+            }
+
+            const __m128 half = _mm_set1_ps(0.5f);
+            // (leftTop, rightTop)
+            __m128 upper = _mm_mul_ps(_mm_add_ps(leftRight, topTop), half);
+            // (leftRight midpoint, leftRight midpoint)
+            __m128 swapped = _mm_shuffle_ps(leftRight, leftRight, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128 base = _mm_mul_ps(_mm_add_ps(leftRight, swapped), half);
+
+            out = subdivideSse(out, depth - 1, _mm_movelh_ps(leftRight, base),
+                               _mm_movelh_ps(upper, upper));
+            out = subdivideSse(out, depth - 1,
+                               _mm_shuffle_ps(base, leftRight, _MM_SHUFFLE(3, 2, 1, 0)),
+                               _mm_movehl_ps(upper, upper));
+            return subdivideSse(out, depth - 1, upper, topTop);
+        }
+#endif
+
+        void subdivide(TaraskModel::Vertex *out, int depth, const Triangle &triangle)
+        {
+            subdivideScalar(out, depth, triangle.left, triangle.right, triangle.top);
+        }
+
+        // Expands the first levels breadth first, in output order, to get independent jobs.
+        std::vector<Triangle> splitTriangles(const Triangle &root, int levels)
+        {
+            std::vector<Triangle> triangles{root};
+            for (int level = 0; level < levels; level++)
+            {
+                std::vector<Triangle> next;
+                next.reserve(triangles.size() * 3);
+                for (const auto &t : triangles)
+                {
+                    auto leftTop = 0.5f * (t.left + t.top);
+                    auto rightTop = 0.5f * (t.right + t.top);
+                    auto leftRight = 0.5f * (t.left + t.right);
+                    next.push_back({t.left, leftRight, leftTop});
+                    next.push_back({leftRight, t.right, rightTop});
+                    next.push_back({leftTop, rightTop, t.top});
+                }
+                triangles.swap(next);
+            }
+            return triangles;
+        }
+
+        // corners added below a node of this depth, preorder: the node's three midpoints, then
+        // each child's subtree in turn
+        uint32_t indexedSubtreeVertices(int depth)
+        {
+            return static_cast<uint32_t>(3 * (TaraskSierpinski::vertexCount(depth) / 3 - 1) / 2);
+        }
+
+        // corners are shared by neighbouring leaves, so midpoints blend color as well
+        inline TaraskModel::Vertex midpoint(const TaraskModel::Vertex &a,
+                                            const TaraskModel::Vertex &b)
+        {
+            return {0.5f * (a.position + b.position), 0.5f * (a.color + b.color)};
+        }
+
+        struct IndexedSubtree
+        {
+            uint32_t next;
+            size_t firstIndex;
+            uint32_t left;
+            uint32_t right;
+            uint32_t top;
+        };
+
+        // Adds the node's midpoints at vertices[next] and hands each child to visit, which
+        // gets the same arguments as this.
+        template <typename Visit>
+        void expandIndexed(TaraskModel::Vertex *vertices, uint32_t next, size_t firstIndex,
+                           int depth, uint32_t left, uint32_t right, uint32_t top, Visit &&visit)
+        {
+            uint32_t leftRight = next;
+            uint32_t rightTop = next + 1;
+            uint32_t leftTop = next + 2;
+            vertices[leftRight] = midpoint(vertices[left], vertices[right]);
+            vertices[rightTop] = midpoint(vertices[right], vertices[top]);
+            vertices[leftTop] = midpoint(vertices[left], vertices[top]);
+
+            uint32_t childVertices = indexedSubtreeVertices(depth - 1);
+            size_t childIndices = TaraskSierpinski::vertexCount(depth - 1);
+            next += 3;
+            visit(next, firstIndex, depth - 1, left, leftRight, leftTop);
+            visit(next + childVertices, firstIndex + childIndices, depth - 1, leftRight, right,
+                  rightTop);
+            visit(next + 2 * childVertices, firstIndex + 2 * childIndices, depth - 1, leftTop,
+                  rightTop, top);
+        }
+
+        void subdivideIndexed(TaraskModel::Vertex *vertices, uint32_t *indices, uint32_t next,
+                              size_t firstIndex, int depth, uint32_t left, uint32_t right,
+                              uint32_t top)
+        {
+            if (depth <= 0)
+            {
+                indices[firstIndex] = top;
+                indices[firstIndex + 1] = right;
+                indices[firstIndex + 2] = left;
+                return;
+            }
+            expandIndexed(vertices, next, firstIndex, depth, left, right, top,
+                          [&](uint32_t childNext, size_t childFirst, int childDepth,
+                              uint32_t childLeft, uint32_t childRight, uint32_t childTop)
+                          {
+                              subdivideIndexed(vertices, indices, childNext, childFirst,
+                                               childDepth, childLeft, childRight, childTop);
+                          });
+        }
+
+        // Expands the first levels on the calling thread, the subtrees below only read the
+        // corners written here and write disjoint ranges.
+        void splitIndexed(TaraskModel::Vertex *vertices, uint32_t next, size_t firstIndex,
+                          int depth, int levels, uint32_t left, uint32_t right, uint32_t top,
+                          std::vector<IndexedSubtree> &subtrees)
+        {
+            if (levels == 0)
+            {
+                subtrees.push_back({next, firstIndex, left, right, top});
+                return;
+            }
+            expandIndexed(vertices, next, firstIndex, depth, left, right, top,
+                          [&](uint32_t childNext, size_t childFirst, int childDepth,
+                              uint32_t childLeft, uint32_t childRight, uint32_t childTop)
+                          {
+                              splitIndexed(vertices, childNext, childFirst, childDepth,
+                                           levels - 1, childLeft, childRight, childTop,
+                                           subtrees);
+                          });
+        }
+
+        // enough subtrees for every thread to get a few, which evens out the split
+        int splitLevelsFor(int depth, uint32_t threadCount)
+        {
+            int levels = 0;
+            size_t subtreeCount = 1;
+            while (levels < depth && subtreeCount < size_t{threadCount} * 4)
+            {
+                levels++;
+                subtreeCount *= 3;
+            }
+            return levels;
+        }
+    } // namespace
+
+    size_t TaraskSierpinski::vertexCount(int depth)
+    {
+        size_t count = 3;
+        for (int i = 0; i < depth; i++)
+        {
+            count *= 3;
+        }
+        return count;
+    }
+
+    void TaraskSierpinski::generate(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                    glm::vec2 right, glm::vec2 top, uint32_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t leaves = vertexCount(depth) / 3;
+        threadCount = static_cast<uint32_t>(
+            std::min<size_t>(threadCount, std::max<size_t>(1, leaves / MIN_LEAVES_PER_THREAD)));
+
+        Triangle root{left, right, top};
+        if (threadCount <= 1)
+        {
+            subdivide(out, depth, root);
+            return;
+        }
+
+        int splitLevels = splitLevelsFor(depth, threadCount);
+        auto subtrees = splitTriangles(root, splitLevels);
+        int subtreeDepth = depth - splitLevels;
+        size_t subtreeVertices = vertexCount(subtreeDepth);
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            size_t first = subtrees.size() * t / threadCount;
+            size_t last = subtrees.size() * (t + 1) / threadCount;
+            threads.emplace_back([&, first, last] {
+                for (size_t i = first; i < last; i++)
+                {
+                    subdivide(out + i * subtreeVertices, subtreeDepth, subtrees[i]);
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void TaraskSierpinski::generate(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                    glm::vec2 right, glm::vec2 top, TaraskJobSystem &jobs)
+    {
+        size_t leaves = vertexCount(depth) / 3;
+        Triangle root{left, right, top};
+        if (leaves < 2 * MIN_LEAVES_PER_THREAD)
+        {
+            subdivide(out, depth, root);
+            return;
+        }
+
+        // subtrees are stolen as workers run dry, so uneven threads still finish together
+        int splitLevels = splitLevelsFor(depth, jobs.threadCount());
+        auto subtrees = splitTriangles(root, splitLevels);
+        int subtreeDepth = depth - splitLevels;
+        size_t subtreeVertices = vertexCount(subtreeDepth);
+        jobs.parallelFor(static_cast<uint32_t>(subtrees.size()),
+                         [&](uint32_t i, uint32_t)
+                         { subdivide(out + i * subtreeVertices, subtreeDepth, subtrees[i]); });
+    }
+
+    std::vector<TaraskModel::Vertex> TaraskSierpinski::generate(int depth, glm::vec2 left,
+                                                                glm::vec2 right, glm::vec2 top,
+                                                                uint32_t threadCount)
+    {
+        std::vector<TaraskModel::Vertex> vertices(vertexCount(depth));
+        generate(vertices.data(), depth, left, right, top, threadCount);
+        return vertices;
+    }
+
+    std::vector<TaraskModel::Vertex> TaraskSierpinski::generate(int depth, glm::vec2 left,
+                                                                glm::vec2 right, glm::vec2 top,
+                                                                TaraskJobSystem &jobs)
+    {
+        std::vector<TaraskModel::Vertex> vertices(vertexCount(depth));
+        generate(vertices.data(), depth, left, right, top, jobs);
+        return vertices;
+    }
+
+    size_t TaraskSierpinski::indexedVertexCount(int depth)
+    {
+        return 3 + indexedSubtreeVertices(depth);
+    }
+
+    void TaraskSierpinski::generateIndexed(int depth, glm::vec2 left, glm::vec2 right,
+                                           glm::vec2 top,
+                                           std::vector<TaraskModel::Vertex> &vertices,
+                                           std::vector<uint32_t> &indices, TaraskJobSystem &jobs)
+    {
+        vertices.resize(indexedVertexCount(depth));
+        indices.resize(vertexCount(depth));
+        vertices[0] = {left, {0.0f, 0.0f, 1.0f}};
+        vertices[1] = {right, {0.0f, 1.0f, 0.0f}};
+        vertices[2] = {top, {1.0f, 0.0f, 0.0f}};
+
+        size_t leaves = vertexCount(depth) / 3;
+        if (leaves < 2 * MIN_LEAVES_PER_THREAD)
+        {
+            subdivideIndexed(vertices.data(), indices.data(), 3, 0, depth, 0, 1, 2);
+            return;
+        }
+
+        std::vector<IndexedSubtree> subtrees;
+        int splitLevels = splitLevelsFor(depth, jobs.threadCount());
+        splitIndexed(vertices.data(), 3, 0, depth, splitLevels, 0, 1, 2, subtrees);
+        int subtreeDepth = depth - splitLevels;
+        jobs.parallelFor(static_cast<uint32_t>(subtrees.size()),
+                         [&](uint32_t i, uint32_t)
+                         {
+                             const IndexedSubtree &subtree = subtrees[i];
+                             subdivideIndexed(vertices.data(), indices.data(), subtree.next,
+                                              subtree.firstIndex, subtreeDepth, subtree.left,
+                                              subtree.right, subtree.top);
+                         });
+    }
+
+    void TaraskSierpinski::generateScalar(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                          glm::vec2 right, glm::vec2 top)
+    {
+        subdivideScalar(out, depth, left, right, top);
+    }
+
+    void TaraskSierpinski::generateSimd(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                        glm::vec2 right, glm::vec2 top)
+    {
+#ifdef TARASK_SIERPINSKI_SSE
+        subdivideSse(out, depth, _mm_setr_ps(left.x, left.y, right.x, right.y),
+                     _mm_setr_ps(top.x, top.y, top.x, top.y));
+#else
+        subdivideScalar(out, depth, left, right, top);
+#endif
+    }
+} // namespace tarask
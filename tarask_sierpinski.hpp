@@ -0,0 +1,54 @@
+#pragma once
+
+#include "tarask_job_system.hpp"
+#include "tarask_model.hpp"
+
+// std lib headers
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tarask
+{
+    // Procedural Sierpinski triangle, produced in the same vertex order as the recursive
+    // FirstApp::sierpinski it replaces: every leaf triangle emits top, right, left colored
+    // red, green and blue.
+    class TaraskSierpinski
+    {
+    public:
+        // Exact number of vertices for a depth, 3 * 3^depth.
+        static size_t vertexCount(int depth);
+
+        // Writes exactly vertexCount(depth) vertices to out, which may be mapped memory.
+        // Subtrees are spread over threadCount threads, 0 picks one per hardware thread.
+        static void generate(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                             glm::vec2 right, glm::vec2 top, uint32_t threadCount = 0);
+        static std::vector<TaraskModel::Vertex> generate(int depth, glm::vec2 left,
+                                                         glm::vec2 right, glm::vec2 top,
+                                                         uint32_t threadCount = 0);
+        // Same, with the subtrees run as jobs.
+        static void generate(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                             glm::vec2 right, glm::vec2 top, TaraskJobSystem &jobs);
+        static std::vector<TaraskModel::Vertex> generate(int depth, glm::vec2 left,
+                                                         glm::vec2 right, glm::vec2 top,
+                                                         TaraskJobSystem &jobs);
+
+        // Indexed variant with one vertex per distinct corner, shared by every leaf triangle
+        // touching it, for (3^(depth + 1) + 3) / 2 vertices instead of 3 * 3^depth. Colors
+        // follow the position, blended from red at top, green at right and blue at left.
+        // indices lists the leaves top, right, left in the same order as generate().
+        static size_t indexedVertexCount(int depth);
+        static void generateIndexed(int depth, glm::vec2 left, glm::vec2 right, glm::vec2 top,
+                                    std::vector<TaraskModel::Vertex> &vertices,
+                                    std::vector<uint32_t> &indices, TaraskJobSystem &jobs);
+
+        // Single threaded scalar path, the one generate() runs on every thread.
+        static void generateScalar(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                   glm::vec2 right, glm::vec2 top);
+        // Single threaded SSE path, scalar where SSE is missing. The loop is bound by stores
+        // and the shuffles cost more than they save, so it measures slower than scalar and
+        // only stays for comparison in bench/sierpinski_bench.
+        static void generateSimd(TaraskModel::Vertex *out, int depth, glm::vec2 left,
+                                 glm::vec2 right, glm::vec2 top);
+    };
+} // namespace tarask
@@ -0,0 +1,57 @@
+#pragma once
+
+// std lib headers
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace tarask
+{
+    // Bounded lock-free queue between exactly one producer thread and one consumer thread.
+    // Each side only writes its own index, so a push or pop is a couple of atomic loads and
+    // one store, and neither thread ever blocks the other.
+    template <typename T, size_t Capacity>
+    class TaraskSpscQueue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                      "TaraskSpscQueue: capacity must be a power of two");
+
+    public:
+        TaraskSpscQueue() = default;
+
+        TaraskSpscQueue(const TaraskSpscQueue &) = delete;
+        TaraskSpscQueue &operator=(const TaraskSpscQueue &) = delete;
+
+        // producer only, false when the queue is full
+        bool tryPush(const T &value)
+        {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            {
+                return false;
+            }
+            m_slots[tail & (Capacity - 1)] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer only, false when the queue is empty
+        bool tryPop(T &value)
+        {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            value = m_slots[head & (Capacity - 1)];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::array<T, Capacity> m_slots{};
+        // on their own cache lines, so the two threads don't keep stealing one from each other
+        alignas(64) std::atomic<size_t> m_head{0};
+        alignas(64) std::atomic<size_t> m_tail{0};
+    };
+} // namespace tarask
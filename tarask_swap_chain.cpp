@@ -1,33 +1,32 @@
 #include "tarask_swap_chain.hpp"
 
+#include "tarask_trace.hpp"
+
 // std
 #include <array>
 #include <cstdlib>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <utility>
 
 namespace tarask
 {
 
-    TaraskSwapChain::TaraskSwapChain(TaraskDevice &deviceRef, VkExtent2D extent)
-        : device{deviceRef}, windowExtent{extent}
-    {
-        init();
-    }
-
-    TaraskSwapChain::TaraskSwapChain(TaraskDevice &deviceRef, VkExtent2D extent, std::shared_ptr<TaraskSwapChain> previous)
-        : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous}
+    TaraskSwapChain::TaraskSwapChain(TaraskDevice &deviceRef, VkExtent2D extent,
+                                     const RenderTargetSettings &settings)
+        : device{deviceRef}, windowExtent{extent}, settings{settings}
     {
         init();
-        oldSwapChain = nullptr;
     }
 
     void TaraskSwapChain::init()
     {
-        createSwapChain();
+        settings.framesInFlight = std::clamp(settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+        createSwapChain(VK_NULL_HANDLE);
         createImageViews();
         createRenderPass();
         createDepthResources();
@@ -37,63 +36,134 @@ namespace tarask
 
     TaraskSwapChain::~TaraskSwapChain()
     {
-        for (auto imageView : swapChainImageViews)
-        {
-            vkDestroyImageView(device.device(), imageView, nullptr);
-        }
-        swapChainImageViews.clear();
+        // frames in flight may still use any of it, the deletion queue outlives them
+        retireImageResources();
+        retireSwapChain(swapChain);
+        retireRenderPass();
+    }
 
-        if (swapChain != nullptr)
-        {
-            vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
-            swapChain = nullptr;
-        }
+    void TaraskSwapChain::recreate(VkExtent2D extent)
+    {
+        windowExtent = extent;
+        VkFormat previousFormat = swapChainImageFormat;
+        VkSwapchainKHR previous = swapChain;
 
-        for (int i = 0; i < depthImages.size(); i++)
+        retireImageResources();
+        createSwapChain(previous);
+        retireSwapChain(previous);
+        createImageViews();
+        if (swapChainImageFormat != previousFormat)
         {
-            vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            retireRenderPass();
+            createRenderPass();
         }
+        createDepthResources();
+        createFramebuffers();
+        // The caller's per image resources are indexed like the images and outlive the swap
+        // chain, so an index keeps waiting on the last frame that used it. Indices without a
+        // history wait on everything submitted so far.
+        imageTimelineValues.resize(imageCount(), device.graphicsTimeline().submittedValue());
+    }
+
+    void TaraskSwapChain::retireImageResources()
+    {
+        TaraskDevice &taraskDevice = device;
+        device.deletionQueue().enqueue(
+            [&taraskDevice, imageViews = std::move(swapChainImageViews),
+             images = std::move(depthImages), allocations = std::move(depthImageAllocations),
+             views = std::move(depthImageViews),
+             framebuffers = std::move(swapChainFramebuffers)]() mutable
+            {
+                for (auto framebuffer : framebuffers)
+                {
+                    vkDestroyFramebuffer(taraskDevice.device(), framebuffer, nullptr);
+                }
+                for (auto imageView : imageViews)
+                {
+                    vkDestroyImageView(taraskDevice.device(), imageView, nullptr);
+                }
+                for (size_t i = 0; i < images.size(); i++)
+                {
+                    vkDestroyImageView(taraskDevice.device(), views[i], nullptr);
+                    taraskDevice.destroyImage(images[i], allocations[i]);
+                }
+            });
+        swapChainImageViews.clear();
+        depthImages.clear();
+        depthImageAllocations.clear();
+        depthImageViews.clear();
+        swapChainFramebuffers.clear();
+    }
 
-        for (auto framebuffer : swapChainFramebuffers)
+    void TaraskSwapChain::retireSwapChain(VkSwapchainKHR retired)
+    {
+        if (retired == VK_NULL_HANDLE)
         {
-            vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+            return;
         }
-
-        vkDestroyRenderPass(device.device(), renderPass, nullptr);
-
-        // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        // Presentation signals nothing on the timeline. Once as many frames as can be in
+        // flight have completed past this point, the old images are no longer on screen.
+        // The present semaphores go with the swap chain when it is destroyed for good.
+        std::vector<VkSemaphore> semaphores;
+        if (retired == swapChain)
         {
-            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-            vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+            semaphores = std::move(imageAvailableSemaphores);
+            semaphores.insert(semaphores.end(), renderFinishedSemaphores.begin(),
+                              renderFinishedSemaphores.end());
+            imageAvailableSemaphores.clear();
+            renderFinishedSemaphores.clear();
+            swapChain = VK_NULL_HANDLE;
         }
+        VkDevice vkDevice = device.device();
+        device.deletionQueue().enqueue(
+            device.graphicsTimeline().submittedValue() + settings.framesInFlight,
+            [vkDevice, retired, semaphores]()
+            {
+                vkDestroySwapchainKHR(vkDevice, retired, nullptr);
+                for (auto semaphore : semaphores)
+                {
+                    vkDestroySemaphore(vkDevice, semaphore, nullptr);
+                }
+            });
+    }
+
+    void TaraskSwapChain::retireRenderPass()
+    {
+        device.deletionQueue().destroyRenderPass(renderPass);
+        renderPass = VK_NULL_HANDLE;
     }
 
     VkResult TaraskSwapChain::acquireNextImage(uint32_t *imageIndex)
     {
-        vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE,
-                        std::numeric_limits<uint64_t>::max());
+        TaraskTimeline &timeline = device.graphicsTimeline();
+        {
+            // the last submit that used this frame's semaphores
+            TARASK_TRACE_SCOPE("waitFrameTimeline");
+            timeline.wait(frameTimelineValues[currentFrame]);
+        }
 
-        VkResult result = vkAcquireNextImageKHR(
-            device.device(), swapChain, std::numeric_limits<uint64_t>::max(),
-            imageAvailableSemaphores[currentFrame], // must be a not signaled semaphore
-            VK_NULL_HANDLE, imageIndex);
+        VkResult result;
+        {
+            TARASK_TRACE_SCOPE("vkAcquireNextImageKHR");
+            result = vkAcquireNextImageKHR(
+                device.device(), swapChain, std::numeric_limits<uint64_t>::max(),
+                imageAvailableSemaphores[currentFrame], // must be a not signaled semaphore
+                VK_NULL_HANDLE, imageIndex);
+        }
 
+        if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+        {
+            // the image can come back while an older frame still renders to it, wait here
+            // rather than in submit so the caller can safely re-record its command buffer
+            TARASK_TRACE_SCOPE("waitImageTimeline");
+            timeline.wait(imageTimelineValues[*imageIndex]);
+        }
         return result;
     }
 
     VkResult TaraskSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers,
                                                    uint32_t *imageIndex)
     {
-        if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
-        {
-            vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-        }
-        imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
-
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -110,11 +180,14 @@ namespace tarask
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-            VK_SUCCESS)
         {
-            throw std::runtime_error("TaraskSwapChain: failed to submit draw command buffer!");
+            // signals the next timeline value, no fence to reset
+            TARASK_TRACE_SCOPE("vkQueueSubmit");
+            TaraskTimeline::Wait uploadWait = device.uploader().graphicsWait();
+            uint64_t value = device.graphicsTimeline().submit(device.graphicsQueue(), submitInfo,
+                                                              &uploadWait, 1);
+            frameTimelineValues[currentFrame] = value;
+            imageTimelineValues[*imageIndex] = value;
         }
 
         VkPresentInfoKHR presentInfo = {};
@@ -129,14 +202,18 @@ namespace tarask
 
         presentInfo.pImageIndices = imageIndex;
 
-        auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        VkResult result;
+        {
+            TARASK_TRACE_SCOPE("vkQueuePresentKHR");
+            result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+        }
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % settings.framesInFlight;
 
         return result;
     }
 
-    void TaraskSwapChain::createSwapChain()
+    void TaraskSwapChain::createSwapChain(VkSwapchainKHR previous)
     {
         SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
@@ -144,7 +221,10 @@ namespace tarask
         VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-        uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+        uint32_t imageCount = settings.imageCount != 0
+                                  ? std::max(settings.imageCount,
+                                             swapChainSupport.capabilities.minImageCount)
+                                  : swapChainSupport.capabilities.minImageCount + 1;
         if (swapChainSupport.capabilities.maxImageCount > 0 &&
             imageCount > swapChainSupport.capabilities.maxImageCount)
         {
@@ -184,7 +264,8 @@ namespace tarask
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
 
-        createInfo.oldSwapchain = oldSwapChain == nullptr ? VK_NULL_HANDLE : oldSwapChain->swapChain;
+        // lets the driver reuse what it can and keeps presenting the old images meanwhile
+        createInfo.oldSwapchain = previous;
 
         if (vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &swapChain) != VK_SUCCESS)
         {
@@ -319,10 +400,11 @@ namespace tarask
     void TaraskSwapChain::createDepthResources()
     {
         VkFormat depthFormat = findDepthFormat();
+        swapChainDepthFormat = depthFormat;
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++)
@@ -344,7 +426,7 @@ namespace tarask
             imageInfo.flags = 0;
 
             device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                       depthImages[i], depthImageMemorys[i]);
+                                       depthImages[i], depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -367,26 +449,22 @@ namespace tarask
 
     void TaraskSwapChain::createSyncObjects()
     {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        imageAvailableSemaphores.resize(settings.framesInFlight);
+        renderFinishedSemaphores.resize(settings.framesInFlight);
+        // 0 is where the timeline starts, so nothing is waited on before the first submit
+        frameTimelineValues.assign(settings.framesInFlight, 0);
+        imageTimelineValues.assign(imageCount(), 0);
 
+        // presentation only works with binary semaphores, the timeline handles the rest
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        for (size_t i = 0; i < settings.framesInFlight; i++)
         {
             if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr,
                                   &imageAvailableSemaphores[i]) != VK_SUCCESS ||
                 vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr,
-                                  &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) !=
-                    VK_SUCCESS)
+                                  &renderFinishedSemaphores[i]) != VK_SUCCESS)
             {
                 throw std::runtime_error(
                     "TaraskSwapChain: failed to create synchronization objects for a frame!");
@@ -409,26 +487,38 @@ namespace tarask
         return availableFormats[0];
     }
 
+    const char *TaraskSwapChain::presentModeName(VkPresentModeKHR presentMode)
+    {
+        switch (presentMode)
+        {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "Immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "Mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "V-Sync";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "Relaxed V-Sync";
+        default:
+            return "Unknown";
+        }
+    }
+
     VkPresentModeKHR TaraskSwapChain::chooseSwapPresentMode(
         const std::vector<VkPresentModeKHR> &availablePresentModes)
     {
         for (const auto &availablePresentMode : availablePresentModes)
         {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+            if (availablePresentMode == settings.presentMode)
             {
-                std::cout << "TaraskSwapChain: Present mode: Mailbox" << std::endl;
+                std::cout << "TaraskSwapChain: Present mode: " << presentModeName(availablePresentMode)
+                          << std::endl;
                 return availablePresentMode;
             }
         }
 
-        // for (const auto &availablePresentMode : availablePresentModes) {
-        //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //     std::cout << "Present mode: Immediate" << std::endl;
-        //     return availablePresentMode;
-        //   }
-        // }
-
-        std::cout << "Present mode: V-Sync" << std::endl;
+        std::cout << "TaraskSwapChain: " << presentModeName(settings.presentMode)
+                  << " unavailable, present mode: V-Sync" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
@@ -1,36 +1,36 @@
 #pragma once
 
 #include "tarask_device.hpp"
+#include "tarask_render_target.hpp"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
 
 // std lib headers
-#include <memory>
 #include <string>
 #include <vector>
 
 namespace tarask
 {
 
-    class TaraskSwapChain
+    class TaraskSwapChain : public TaraskRenderTarget
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-        TaraskSwapChain(TaraskDevice &deviceRef, VkExtent2D windowExtent);
-        TaraskSwapChain(TaraskDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<TaraskSwapChain> previous);
-        ~TaraskSwapChain();
+        TaraskSwapChain(TaraskDevice &deviceRef, VkExtent2D windowExtent,
+                        const RenderTargetSettings &settings = RenderTargetSettings{});
+        ~TaraskSwapChain() override;
 
         TaraskSwapChain(const TaraskSwapChain &) = delete;
         TaraskSwapChain &operator=(const TaraskSwapChain &) = delete;
 
-        VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-        VkRenderPass getRenderPass() { return renderPass; }
+        VkFramebuffer getFrameBuffer(int index) override { return swapChainFramebuffers[index]; }
+        VkRenderPass getRenderPass() override { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
-        size_t imageCount() { return swapChainImages.size(); }
-        VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
-        VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+        size_t imageCount() override { return swapChainImages.size(); }
+        uint32_t framesInFlight() override { return settings.framesInFlight; }
+        VkFormat getSwapChainImageFormat() override { return swapChainImageFormat; }
+        VkFormat getSwapChainDepthFormat() override { return swapChainDepthFormat; }
+        VkExtent2D getSwapChainExtent() override { return swapChainExtent; }
         uint32_t width() { return swapChainExtent.width; }
         uint32_t height() { return swapChainExtent.height; }
 
@@ -40,18 +40,28 @@ namespace tarask
                    static_cast<float>(swapChainExtent.height);
         }
         VkFormat findDepthFormat();
+        static const char *presentModeName(VkPresentModeKHR presentMode);
+
+        // Hands the surface over to a new swap chain through oldSwapchain. The semaphores are
+        // kept, and so is the render pass unless the surface format changed. Old image views,
+        // depth images, framebuffers and the old swap chain go to the device deletion queue.
+        void recreate(VkExtent2D extent) override;
 
-        VkResult acquireNextImage(uint32_t *imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+        VkResult acquireNextImage(uint32_t *imageIndex) override;
+        VkResult submitCommandBuffers(const VkCommandBuffer *buffers,
+                                      uint32_t *imageIndex) override;
 
     private:
         void init();
-        void createSwapChain();
+        void createSwapChain(VkSwapchainKHR previous);
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
         void createFramebuffers();
         void createSyncObjects();
+        void retireImageResources();
+        void retireSwapChain(VkSwapchainKHR retired);
+        void retireRenderPass();
 
         // Helper functions
         VkSurfaceFormatKHR
@@ -61,27 +71,29 @@ namespace tarask
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
 
         VkFormat swapChainImageFormat;
+        VkFormat swapChainDepthFormat;
         VkExtent2D swapChainExtent;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<TaraskAllocation> depthImageAllocations;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
 
         TaraskDevice &device;
         VkExtent2D windowExtent;
+        RenderTargetSettings settings;
 
-        VkSwapchainKHR swapChain;
-        std::shared_ptr<TaraskSwapChain> oldSwapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
-        std::vector<VkFence> inFlightFences;
-        std::vector<VkFence> imagesInFlight;
+        // graphics timeline value of the last submit per frame slot and per image
+        std::vector<uint64_t> frameTimelineValues;
+        std::vector<uint64_t> imageTimelineValues;
         size_t currentFrame = 0;
     };
 
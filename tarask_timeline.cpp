@@ -0,0 +1,265 @@
+#include "tarask_timeline.hpp"
+
+#include "tarask_device.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace tarask
+{
+    TaraskTimeline::TaraskTimeline(TaraskDevice &device) : m_taraskDevice{device}
+    {
+        if (!m_taraskDevice.supportsTimelineSemaphores())
+        {
+            return;
+        }
+
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+        if (vkCreateSemaphore(m_taraskDevice.device(), &semaphoreInfo, nullptr, &m_semaphore) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskTimeline: failed to create timeline semaphore.");
+        }
+    }
+
+    TaraskTimeline::~TaraskTimeline()
+    {
+        wait(m_submitted);
+        if (m_semaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(m_taraskDevice.device(), m_semaphore, nullptr);
+        }
+        for (auto fence : m_freeFences)
+        {
+            vkDestroyFence(m_taraskDevice.device(), fence, nullptr);
+        }
+        for (auto fence : m_unresetFences)
+        {
+            vkDestroyFence(m_taraskDevice.device(), fence, nullptr);
+        }
+    }
+
+    uint64_t TaraskTimeline::submit(VkQueue queue, const VkSubmitInfo &submitInfo,
+                                    const Wait *waits, uint32_t waitCount)
+    {
+        if (m_semaphore == VK_NULL_HANDLE)
+        {
+            // before taking the lock, so nobody else has to wait on the other timelines too
+            for (uint32_t i = 0; i < waitCount; i++)
+            {
+                waits[i].timeline->wait(waits[i].value);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock{m_mutex};
+        uint64_t value = m_submitted + 1;
+
+        if (m_semaphore == VK_NULL_HANDLE)
+        {
+            VkFence fence = acquireFence();
+            if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS)
+            {
+                m_freeFences.push_back(fence);
+                throw std::runtime_error("TaraskTimeline: failed to submit.");
+            }
+            m_pendingFences.push_back({value, fence});
+            m_submitted = value;
+            return value;
+        }
+
+        uint32_t waitSemaphoreCount = submitInfo.waitSemaphoreCount + waitCount;
+        uint32_t signalSemaphoreCount = submitInfo.signalSemaphoreCount + 1;
+        if (waitSemaphoreCount > MAX_SEMAPHORES || signalSemaphoreCount > MAX_SEMAPHORES)
+        {
+            throw std::runtime_error("TaraskTimeline: too many semaphores in one submit.");
+        }
+
+        // binary semaphores ignore their value, they only need a slot in the arrays
+        std::array<VkSemaphore, MAX_SEMAPHORES> waitSemaphores{};
+        std::array<VkPipelineStageFlags, MAX_SEMAPHORES> waitStages{};
+        std::array<uint64_t, MAX_SEMAPHORES> waitValues{};
+        for (uint32_t i = 0; i < submitInfo.waitSemaphoreCount; i++)
+        {
+            waitSemaphores[i] = submitInfo.pWaitSemaphores[i];
+            waitStages[i] = submitInfo.pWaitDstStageMask[i];
+        }
+        for (uint32_t i = 0; i < waitCount; i++)
+        {
+            uint32_t slot = submitInfo.waitSemaphoreCount + i;
+            waitSemaphores[slot] = waits[i].timeline->semaphore();
+            waitStages[slot] = waits[i].stage;
+            waitValues[slot] = waits[i].value;
+        }
+
+        std::array<VkSemaphore, MAX_SEMAPHORES> signalSemaphores{};
+        std::array<uint64_t, MAX_SEMAPHORES> signalValues{};
+        for (uint32_t i = 0; i < submitInfo.signalSemaphoreCount; i++)
+        {
+            signalSemaphores[i] = submitInfo.pSignalSemaphores[i];
+        }
+        signalSemaphores[submitInfo.signalSemaphoreCount] = m_semaphore;
+        signalValues[submitInfo.signalSemaphoreCount] = value;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = waitSemaphoreCount;
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = signalSemaphoreCount;
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+        VkSubmitInfo timelineSubmit = submitInfo;
+        timelineSubmit.pNext = &timelineInfo;
+        timelineSubmit.waitSemaphoreCount = waitSemaphoreCount;
+        timelineSubmit.pWaitSemaphores = waitSemaphores.data();
+        timelineSubmit.pWaitDstStageMask = waitStages.data();
+        timelineSubmit.signalSemaphoreCount = signalSemaphoreCount;
+        timelineSubmit.pSignalSemaphores = signalSemaphores.data();
+        if (vkQueueSubmit(queue, 1, &timelineSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskTimeline: failed to submit.");
+        }
+        m_submitted = value;
+        return value;
+    }
+
+    uint64_t TaraskTimeline::submittedValue()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_submitted;
+    }
+
+    uint64_t TaraskTimeline::completedValue()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_semaphore != VK_NULL_HANDLE)
+        {
+            m_taraskDevice.getSemaphoreCounterValue(m_semaphore, &m_completed);
+        }
+        else
+        {
+            retireFences();
+        }
+        return m_completed;
+    }
+
+    bool TaraskTimeline::isComplete(uint64_t value)
+    {
+        {
+            // the cached value answers most queries without a call into the driver
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (value <= m_completed)
+            {
+                return true;
+            }
+        }
+        return value <= completedValue();
+    }
+
+    void TaraskTimeline::wait(uint64_t value)
+    {
+        if (isComplete(value))
+        {
+            return;
+        }
+
+        if (m_semaphore != VK_NULL_HANDLE)
+        {
+            assert(value <= submittedValue() && "TaraskTimeline: waiting on an unsubmitted value");
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &m_semaphore;
+            waitInfo.pValues = &value;
+            // no lock while blocked, other threads keep submitting
+            m_taraskDevice.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max());
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_completed = std::max(m_completed, value);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+        assert(value <= m_submitted && "TaraskTimeline: waiting on an unsubmitted value");
+        while (m_completed < value && !m_pendingFences.empty())
+        {
+            // a queue's fences signal in submission order, so the first fence at or past value
+            // is enough
+            auto pending = std::find_if(m_pendingFences.begin(), m_pendingFences.end(),
+                                        [value](const PendingFence &candidate)
+                                        { return candidate.value >= value; });
+            VkFence fence = pending->fence;
+            // no lock while blocked either, retireFences() leaves the fence alone meanwhile
+            m_fenceWaiters++;
+            lock.unlock();
+            vkWaitForFences(m_taraskDevice.device(), 1, &fence, VK_TRUE,
+                            std::numeric_limits<uint64_t>::max());
+            lock.lock();
+            m_fenceWaiters--;
+            retireFences();
+        }
+    }
+
+    VkFence TaraskTimeline::acquireFence()
+    {
+        retireFences();
+        if (!m_freeFences.empty())
+        {
+            VkFence fence = m_freeFences.back();
+            m_freeFences.pop_back();
+            return fence;
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if (vkCreateFence(m_taraskDevice.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskTimeline: failed to create fence.");
+        }
+        return fence;
+    }
+
+    void TaraskTimeline::retireFences()
+    {
+        // a fence another thread is blocked on must not be reset under it
+        if (m_fenceWaiters == 0 && !m_unresetFences.empty())
+        {
+            vkResetFences(m_taraskDevice.device(), static_cast<uint32_t>(m_unresetFences.size()),
+                          m_unresetFences.data());
+            m_freeFences.insert(m_freeFences.end(), m_unresetFences.begin(),
+                                m_unresetFences.end());
+            m_unresetFences.clear();
+        }
+
+        while (!m_pendingFences.empty())
+        {
+            PendingFence &pending = m_pendingFences.front();
+            if (vkGetFenceStatus(m_taraskDevice.device(), pending.fence) != VK_SUCCESS)
+            {
+                break;
+            }
+
+            // reset here rather than before the next submit, off the frame's critical path
+            if (m_fenceWaiters == 0)
+            {
+                vkResetFences(m_taraskDevice.device(), 1, &pending.fence);
+                m_freeFences.push_back(pending.fence);
+            }
+            else
+            {
+                m_unresetFences.push_back(pending.fence);
+            }
+            m_completed = pending.value;
+            m_pendingFences.pop_front();
+        }
+    }
+} // namespace tarask
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace tarask
+{
+    class TaraskDevice;
+
+    // A counter that goes up by one with every submission made through it. Waiting for a
+    // value means waiting for that submission and, because the counter is monotonic, every
+    // earlier one too. Backed by a timeline semaphore when VK_KHR_timeline_semaphore is
+    // available, otherwise by one fence per submission that is recycled once it completes.
+    class TaraskTimeline
+    {
+    public:
+        // makes a submission wait until another timeline has reached value
+        struct Wait
+        {
+            TaraskTimeline *timeline;
+            uint64_t value;
+            VkPipelineStageFlags stage;
+        };
+
+        // binary semaphores of the submit info plus this timeline and its waits
+        static constexpr uint32_t MAX_SEMAPHORES = 8;
+
+        TaraskTimeline(TaraskDevice &device);
+        ~TaraskTimeline();
+
+        TaraskTimeline(const TaraskTimeline &) = delete;
+        TaraskTimeline &operator=(const TaraskTimeline &) = delete;
+
+        // Submits one batch that signals the next value, on top of whatever binary semaphores
+        // submitInfo already waits on and signals, and returns that value. Without timeline
+        // semaphores the waits on other timelines happen on the CPU before the submit.
+        uint64_t submit(VkQueue queue, const VkSubmitInfo &submitInfo, const Wait *waits = nullptr,
+                        uint32_t waitCount = 0);
+
+        uint64_t submittedValue();
+        uint64_t completedValue();
+        bool isComplete(uint64_t value);
+        // value must already be submitted
+        void wait(uint64_t value);
+
+        bool usesTimelineSemaphore() const { return m_semaphore != VK_NULL_HANDLE; }
+        VkSemaphore semaphore() const { return m_semaphore; }
+
+    private:
+        struct PendingFence
+        {
+            uint64_t value;
+            VkFence fence;
+        };
+
+        VkFence acquireFence();
+        // fence mode only, moves finished fences back to the free list without blocking
+        void retireFences();
+
+        TaraskDevice &m_taraskDevice;
+        VkSemaphore m_semaphore = VK_NULL_HANDLE;
+        uint64_t m_submitted = 0;
+        uint64_t m_completed = 0;
+        std::deque<PendingFence> m_pendingFences;
+        std::vector<VkFence> m_freeFences;
+        // finished while a wait() was blocked on a fence, reset once none is
+        std::vector<VkFence> m_unresetFences;
+        uint32_t m_fenceWaiters = 0;
+        std::mutex m_mutex;
+    };
+} // namespace tarask
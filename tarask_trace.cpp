@@ -0,0 +1,136 @@
+#include "tarask_trace.hpp"
+
+#ifdef TARASK_ENABLE_TRACE
+
+// std lib headers
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tarask
+{
+    namespace
+    {
+        struct TraceEvent
+        {
+            const char *name;
+            uint64_t startNs;
+            uint64_t endNs;
+        };
+
+        // written only by its thread, read by dump()
+        struct ThreadRing
+        {
+            uint32_t threadId;
+            std::string threadName;
+            std::vector<TraceEvent> events;
+            std::atomic<uint64_t> written{0};
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            // shared so a ring outlives its thread until the dump
+            std::vector<std::shared_ptr<ThreadRing>> rings;
+        };
+
+        // taken during static initialization, before any zone can start
+        const uint64_t originNs = TaraskTrace::nowNs();
+
+        Registry &registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadRing &threadRing()
+        {
+            // the lock is only taken once per thread, recording itself is lock free
+            thread_local std::shared_ptr<ThreadRing> ring = [] {
+                auto created = std::make_shared<ThreadRing>();
+                created->events.resize(TaraskTrace::RING_CAPACITY);
+                auto &reg = registry();
+                std::lock_guard<std::mutex> lock{reg.mutex};
+                created->threadId = static_cast<uint32_t>(reg.rings.size()) + 1;
+                reg.rings.push_back(created);
+                return created;
+            }();
+            return *ring;
+        }
+
+        void writeEscaped(std::FILE *out, const std::string &text)
+        {
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    std::fputc('\\', out);
+                }
+                std::fputc(c, out);
+            }
+        }
+    } // namespace
+
+    void TaraskTrace::record(const char *name, uint64_t startNs, uint64_t endNs)
+    {
+        ThreadRing &ring = threadRing();
+        uint64_t index = ring.written.load(std::memory_order_relaxed);
+        ring.events[index % RING_CAPACITY] = {name, startNs, endNs};
+        ring.written.store(index + 1, std::memory_order_release);
+    }
+
+    void TaraskTrace::setThreadName(const std::string &name)
+    {
+        ThreadRing &ring = threadRing();
+        std::lock_guard<std::mutex> lock{registry().mutex};
+        ring.threadName = name;
+    }
+
+    bool TaraskTrace::dump(const std::string &path)
+    {
+        std::FILE *out = std::fopen(path.c_str(), "w");
+        if (out == nullptr)
+        {
+            return false;
+        }
+
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock{reg.mutex};
+        std::fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+        bool first = true;
+        for (const auto &ring : reg.rings)
+        {
+            if (!ring->threadName.empty())
+            {
+                std::fprintf(out,
+                             "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                             "\"tid\": %u, \"args\": {\"name\": \"",
+                             first ? "" : ",\n", ring->threadId);
+                writeEscaped(out, ring->threadName);
+                std::fprintf(out, "\"}}");
+                first = false;
+            }
+
+            uint64_t written = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+            for (uint64_t i = begin; i < written; i++)
+            {
+                const TraceEvent &event = ring->events[i % RING_CAPACITY];
+                // trace_event timestamps are microseconds
+                std::fprintf(out,
+                             "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+                             "\"ts\": %.3f, \"dur\": %.3f}",
+                             first ? "" : ",\n", event.name, ring->threadId,
+                             static_cast<int64_t>(event.startNs - originNs) * 1e-3,
+                             (event.endNs - event.startNs) * 1e-3);
+                first = false;
+            }
+        }
+        std::fprintf(out, "\n]}\n");
+        return std::fclose(out) == 0;
+    }
+} // namespace tarask
+
+#endif
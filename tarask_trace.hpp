@@ -0,0 +1,69 @@
+#pragma once
+
+// CPU zone tracing. Build with -DTARASK_ENABLE_TRACE (make TRACE=1) to record; without it
+// every TARASK_TRACE_* macro expands to nothing and no code is generated.
+//
+//     TARASK_TRACE_SCOPE("recordCommandBuffer");  // times the rest of the enclosing block
+//     TARASK_TRACE_THREAD("pipeline compiler");   // names the calling thread in the viewer
+//     TARASK_TRACE_DUMP("tarask_trace.json");     // writes chrome://tracing / Perfetto JSON
+
+#ifdef TARASK_ENABLE_TRACE
+
+// std lib headers
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace tarask
+{
+    class TaraskTrace
+    {
+    public:
+        // events kept per thread, older ones are overwritten
+        static constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+        // Records a complete zone on the calling thread. name must outlive the dump,
+        // string literals are what the macros pass.
+        static void record(const char *name, uint64_t startNs, uint64_t endNs);
+        static void setThreadName(const std::string &name);
+        // Writes the events of every thread that ever recorded. Threads may keep recording,
+        // but a ring that wraps during the dump can show a few torn events.
+        static bool dump(const std::string &path);
+
+        static uint64_t nowNs()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+        }
+
+        class Scope
+        {
+        public:
+            explicit Scope(const char *name) : m_name{name}, m_startNs{nowNs()} {}
+            ~Scope() { record(m_name, m_startNs, nowNs()); }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            const char *m_name;
+            uint64_t m_startNs;
+        };
+    };
+} // namespace tarask
+
+#define TARASK_TRACE_CONCAT_INNER(a, b) a##b
+#define TARASK_TRACE_CONCAT(a, b) TARASK_TRACE_CONCAT_INNER(a, b)
+#define TARASK_TRACE_SCOPE(name) \
+    ::tarask::TaraskTrace::Scope TARASK_TRACE_CONCAT(taraskTraceScope, __LINE__) { name }
+#define TARASK_TRACE_THREAD(name) ::tarask::TaraskTrace::setThreadName(name)
+#define TARASK_TRACE_DUMP(path) ::tarask::TaraskTrace::dump(path)
+
+#else
+
+#define TARASK_TRACE_SCOPE(name)
+#define TARASK_TRACE_THREAD(name)
+#define TARASK_TRACE_DUMP(path)
+
+#endif
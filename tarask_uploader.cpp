@@ -0,0 +1,364 @@
+#include "tarask_uploader.hpp"
+
+#include "tarask_device.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace tarask
+{
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    TaraskUploader::TaraskUploader(TaraskDevice &device, VkDeviceSize stagingSize)
+        : m_taraskDevice{device}, m_stagingSize{stagingSize}, m_timeline{device}
+    {
+        m_queue = m_taraskDevice.transferQueue();
+        m_queueFamily = m_taraskDevice.transferQueueFamily();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = m_queueFamily;
+        poolInfo.flags =
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (vkCreateCommandPool(m_taraskDevice.device(), &poolInfo, nullptr, &m_commandPool) !=
+            VK_SUCCESS)
+        {
+            throw std::runtime_error("TaraskUploader: failed to create command pool.");
+        }
+
+        m_taraskDevice.createBuffer(m_stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                    m_stagingBuffer, m_stagingAllocation,
+                                    AllocationStrategy::Linear);
+    }
+
+    TaraskUploader::~TaraskUploader()
+    {
+        if (m_recording != nullptr)
+        {
+            submitRecordingBatch();
+        }
+        while (!m_inFlight.empty())
+        {
+            retireCompletedBatches(true);
+        }
+
+        vkDestroyCommandPool(m_taraskDevice.device(), m_commandPool, nullptr);
+        m_taraskDevice.destroyBuffer(m_stagingBuffer, m_stagingAllocation);
+    }
+
+    UploadTicket TaraskUploader::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset,
+                                              const void *data, VkDeviceSize size)
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+
+        // anything larger than half the ring is streamed in chunks, so a single big upload
+        // can't deadlock against itself
+        const char *bytes = static_cast<const char *>(data);
+        VkDeviceSize maxChunk = m_stagingSize / 2;
+        UploadTicket ticket = 0;
+        for (VkDeviceSize done = 0; done < size;)
+        {
+            VkDeviceSize chunk = std::min(maxChunk, size - done);
+            VkDeviceSize stagingOffset = reserveStaging(chunk, 16);
+            memcpy(static_cast<char *>(m_stagingAllocation.mappedData) + stagingOffset,
+                   bytes + done, static_cast<size_t>(chunk));
+
+            Batch &batch = recordingBatch();
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = stagingOffset;
+            copyRegion.dstOffset = dstOffset + done;
+            copyRegion.size = chunk;
+            vkCmdCopyBuffer(batch.commandBuffer, m_stagingBuffer, dstBuffer, 1, &copyRegion);
+            ticket = batch.ticket;
+            done += chunk;
+        }
+        return ticket;
+    }
+
+    UploadTicket TaraskUploader::uploadImage(VkImage image, uint32_t width, uint32_t height,
+                                             uint32_t layerCount, const void *data,
+                                             VkDeviceSize size, VkImageLayout finalLayout)
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (size > m_stagingSize / 2)
+        {
+            throw std::runtime_error("TaraskUploader: image is too large for the staging ring.");
+        }
+
+        VkDeviceSize alignment = std::max<VkDeviceSize>(
+            16, m_taraskDevice.properties.limits.optimalBufferCopyOffsetAlignment);
+        VkDeviceSize stagingOffset = reserveStaging(size, alignment);
+        memcpy(static_cast<char *>(m_stagingAllocation.mappedData) + stagingOffset, data,
+               static_cast<size_t>(size));
+
+        Batch &batch = recordingBatch();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+        vkCmdCopyBufferToImage(batch.commandBuffer, m_stagingBuffer, image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // a transfer only queue can't name the shader stages, visibility for the graphics
+        // queue comes from waiting on the batch instead
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = finalLayout;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &barrier);
+        return batch.ticket;
+    }
+
+    UploadTicket TaraskUploader::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
+                                            VkDeviceSize size)
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        Batch &batch = recordingBatch();
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = 0;
+        copyRegion.dstOffset = 0;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(batch.commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+        return batch.ticket;
+    }
+
+    UploadTicket TaraskUploader::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
+                                                   uint32_t height, uint32_t layerCount)
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        Batch &batch = recordingBatch();
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+        vkCmdCopyBufferToImage(batch.commandBuffer, buffer, image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        return batch.ticket;
+    }
+
+    UploadTicket TaraskUploader::flush()
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (m_recording == nullptr)
+        {
+            return m_nextTicket - 1;
+        }
+        return submitRecordingBatch();
+    }
+
+    bool TaraskUploader::isComplete(UploadTicket ticket)
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        retireCompletedBatches(false);
+        return m_timeline.isComplete(ticket);
+    }
+
+    bool TaraskUploader::isVisibleToGraphics(UploadTicket ticket)
+    {
+        if (m_timeline.usesTimelineSemaphore())
+        {
+            return ticket <= m_timeline.submittedValue();
+        }
+        return isComplete(ticket);
+    }
+
+    TaraskTimeline::Wait TaraskUploader::graphicsWait()
+    {
+        // the copies may feed anything from indirect commands to fragment shaders
+        return {&m_timeline, m_timeline.submittedValue(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+    }
+
+    void TaraskUploader::wait(UploadTicket ticket)
+    {
+        std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (m_recording != nullptr && ticket >= m_recording->ticket)
+        {
+            submitRecordingBatch();
+        }
+        m_timeline.wait(std::min(ticket, m_timeline.submittedValue()));
+        retireCompletedBatches(false);
+    }
+
+    TaraskUploader::Batch &TaraskUploader::recordingBatch()
+    {
+        if (m_recording != nullptr)
+        {
+            return *m_recording;
+        }
+
+        if (m_freeBatches.empty())
+        {
+            auto batch = std::make_unique<Batch>();
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = m_commandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(m_taraskDevice.device(), &allocInfo,
+                                         &batch->commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("TaraskUploader: failed to allocate command buffer.");
+            }
+
+            m_freeBatches.push_back(batch.get());
+            m_batches.push_back(std::move(batch));
+        }
+
+        m_recording = m_freeBatches.back();
+        m_freeBatches.pop_back();
+        m_recording->ticket = m_nextTicket++;
+        m_recording->ringBytes = 0;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkResetCommandBuffer(m_recording->commandBuffer, 0);
+        vkBeginCommandBuffer(m_recording->commandBuffer, &beginInfo);
+        return *m_recording;
+    }
+
+    UploadTicket TaraskUploader::submitRecordingBatch()
+    {
+        Batch *batch = m_recording;
+        m_recording = nullptr;
+        vkEndCommandBuffer(batch->commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch->commandBuffer;
+        // batches are submitted in ticket order, so the timeline hands out the same values
+        UploadTicket value = m_timeline.submit(m_queue, submitInfo);
+        assert(value == batch->ticket && "TaraskUploader: batch submitted out of order");
+        (void)value;
+
+        m_inFlight.push_back(batch);
+        return batch->ticket;
+    }
+
+    void TaraskUploader::retireCompletedBatches(bool waitForOldest)
+    {
+        if (waitForOldest && !m_inFlight.empty())
+        {
+            m_timeline.wait(m_inFlight.front()->ticket);
+        }
+        uint64_t completed = m_timeline.completedValue();
+        while (!m_inFlight.empty() && m_inFlight.front()->ticket <= completed)
+        {
+            Batch *batch = m_inFlight.front();
+            m_ringUsed -= batch->ringBytes;
+            m_inFlight.pop_front();
+            m_freeBatches.push_back(batch);
+        }
+    }
+
+    VkDeviceSize TaraskUploader::reserveStaging(VkDeviceSize size, VkDeviceSize alignment)
+    {
+        VkDeviceSize offset;
+        VkDeviceSize consumed;
+        while (!tryReserveStaging(size, alignment, offset, consumed))
+        {
+            // make room: push out what we have and wait for the oldest batch to retire
+            if (m_recording != nullptr && m_recording->ringBytes > 0)
+            {
+                submitRecordingBatch();
+            }
+            if (m_inFlight.empty())
+            {
+                throw std::runtime_error("TaraskUploader: upload does not fit in staging ring.");
+            }
+            retireCompletedBatches(true);
+        }
+        recordingBatch().ringBytes += consumed;
+        return offset;
+    }
+
+    bool TaraskUploader::tryReserveStaging(VkDeviceSize size, VkDeviceSize alignment,
+                                           VkDeviceSize &offset, VkDeviceSize &consumed)
+    {
+        if (m_ringUsed == 0)
+        {
+            m_ringHead = 0;
+        }
+        if (m_ringUsed == m_stagingSize)
+        {
+            return false;
+        }
+
+        VkDeviceSize tail = (m_ringHead + m_stagingSize - m_ringUsed) % m_stagingSize;
+        VkDeviceSize aligned = alignUp(m_ringHead, alignment);
+        if (m_ringUsed == 0 || m_ringHead > tail)
+        {
+            if (aligned + size <= m_stagingSize)
+            {
+                offset = aligned;
+            }
+            else if (size <= tail)
+            {
+                // wrap around, the unused end of the ring is charged to this batch
+                offset = 0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (aligned + size <= tail)
+        {
+            offset = aligned;
+        }
+        else
+        {
+            return false;
+        }
+
+        consumed = offset == 0 && m_ringHead > 0 ? m_stagingSize - m_ringHead + size
+                                                 : offset + size - m_ringHead;
+        m_ringHead = offset + size;
+        m_ringUsed += consumed;
+        return true;
+    }
+} // namespace tarask
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "tarask_allocator.hpp"
+#include "tarask_timeline.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tarask
+{
+    class TaraskDevice;
+
+    // Identifies the batch an upload was recorded into. Tickets are the values of the
+    // uploader's TaraskTimeline, so a completed ticket implies every smaller ticket has
+    // completed as well.
+    using UploadTicket = uint64_t;
+
+    // Streams data to device local resources through a persistently mapped staging ring.
+    // Copies are batched into one command buffer per flush and submitted to the dedicated
+    // transfer queue when the device has one. Completion is tracked on a TaraskTimeline, so
+    // nothing here ever waits on the graphics queue.
+    class TaraskUploader
+    {
+    public:
+        static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+        TaraskUploader(TaraskDevice &device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+        ~TaraskUploader();
+
+        TaraskUploader(const TaraskUploader &) = delete;
+        TaraskUploader &operator=(const TaraskUploader &) = delete;
+
+        UploadTicket uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data,
+                                  VkDeviceSize size);
+        // Transitions the whole image from UNDEFINED to finalLayout around the copy.
+        UploadTicket uploadImage(VkImage image, uint32_t width, uint32_t height,
+                                 uint32_t layerCount, const void *data, VkDeviceSize size,
+                                 VkImageLayout finalLayout);
+        UploadTicket copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        // The image must already be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
+        UploadTicket copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
+                                       uint32_t height, uint32_t layerCount);
+
+        // Submits everything recorded so far and returns the ticket of that batch.
+        UploadTicket flush();
+        bool isComplete(UploadTicket ticket);
+        void wait(UploadTicket ticket);
+        // True once graphics submissions are ordered after the ticket's copies. With timeline
+        // semaphores that is as soon as it is submitted, since the render targets make every
+        // graphics submit wait on graphicsWait(). Otherwise the ticket has to be complete.
+        bool isVisibleToGraphics(UploadTicket ticket);
+        // GPU side wait on everything submitted so far, for graphics queue submissions
+        TaraskTimeline::Wait graphicsWait();
+        TaraskTimeline &timeline() { return m_timeline; }
+
+        uint32_t queueFamily() { return m_queueFamily; }
+
+    private:
+        struct Batch
+        {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            UploadTicket ticket = 0;
+            VkDeviceSize ringBytes = 0;
+            bool hasCommands = false;
+        };
+
+        Batch &recordingBatch();
+        UploadTicket submitRecordingBatch();
+        void retireCompletedBatches(bool waitForOldest);
+        VkDeviceSize reserveStaging(VkDeviceSize size, VkDeviceSize alignment);
+        bool tryReserveStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset,
+                               VkDeviceSize &consumed);
+
+        TaraskDevice &m_taraskDevice;
+        VkQueue m_queue;
+        uint32_t m_queueFamily;
+        VkCommandPool m_commandPool;
+
+        VkBuffer m_stagingBuffer;
+        TaraskAllocation m_stagingAllocation;
+        VkDeviceSize m_stagingSize;
+        VkDeviceSize m_ringHead = 0;
+        VkDeviceSize m_ringUsed = 0;
+
+        Batch *m_recording = nullptr;
+        std::deque<Batch *> m_inFlight;
+        std::vector<Batch *> m_freeBatches;
+        std::vector<std::unique_ptr<Batch>> m_batches;
+
+        TaraskTimeline m_timeline;
+        UploadTicket m_nextTicket = 1;
+        std::recursive_mutex m_mutex;
+    };
+} // namespace tarask
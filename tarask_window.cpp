@@ -5,8 +5,9 @@
 namespace tarask
 {
     TaraskWindow::TaraskWindow(uint32_t width, uint32_t height, const std::string &title)
-        : m_width(width), m_height(height), m_title(title)
+        : m_title(title)
     {
+        setExtent(static_cast<int>(width), static_cast<int>(height));
         initWindow();
     }
 
@@ -22,7 +23,10 @@ namespace tarask
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-        m_window = glfwCreateWindow(m_width, m_height, m_title.c_str(), nullptr, nullptr);
+        VkExtent2D extent = getExtent();
+        m_window = glfwCreateWindow(static_cast<int>(extent.width),
+                                    static_cast<int>(extent.height), m_title.c_str(), nullptr,
+                                    nullptr);
         glfwSetWindowUserPointer(m_window, this);
         glfwSetFramebufferSizeCallback(m_window, framebufferResizeCallback);
     }
@@ -38,8 +42,14 @@ namespace tarask
     void TaraskWindow::framebufferResizeCallback(GLFWwindow *window, int width, int height)
     {
         auto taraskWindow = reinterpret_cast<TaraskWindow *>(glfwGetWindowUserPointer(window));
-        taraskWindow->m_framebufferResized = true;
-        taraskWindow->m_width = width;
-        taraskWindow->m_height = height;
+        // the extent first, whoever sees the flag must also see the new size
+        taraskWindow->setExtent(width, height);
+        taraskWindow->m_framebufferResized.store(true, std::memory_order_release);
+    }
+
+    void TaraskWindow::setExtent(int width, int height)
+    {
+        m_extent.store((static_cast<uint64_t>(width) << 32) | static_cast<uint32_t>(height),
+                       std::memory_order_release);
     }
 } // namespace tarask
\ No newline at end of file
@@ -2,10 +2,16 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+
+// std lib headers
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 namespace tarask
 {
+    // The GLFW calls must come from the main thread. The extent and the resize flag are
+    // written by the callbacks there but may be read from any thread, e.g. the render thread.
     class TaraskWindow
     {
     public:
@@ -18,10 +24,14 @@ namespace tarask
         bool shouldClose() { return glfwWindowShouldClose(m_window); }
         VkExtent2D getExtent()
         {
-            return {static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height)};
+            // packed into one word, so a reader never pairs a new width with an old height
+            uint64_t extent = m_extent.load(std::memory_order_acquire);
+            return {static_cast<uint32_t>(extent >> 32), static_cast<uint32_t>(extent)};
         }
-        bool wasWindowResized() { return m_framebufferResized; }
-        void resetWindowResizedFlag() { m_framebufferResized = false; }
+        bool wasWindowResized() { return m_framebufferResized.load(std::memory_order_acquire); }
+        // Clears the resize flag and returns whether it was set, in one step so a resize that
+        // lands in between is never lost.
+        bool consumeWindowResized() { return m_framebufferResized.exchange(false); }
 
         void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
@@ -29,9 +39,10 @@ namespace tarask
         static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
         void initWindow();
 
-        int m_width;
-        int m_height;
-        bool m_framebufferResized = false;
+        void setExtent(int width, int height);
+
+        std::atomic<uint64_t> m_extent{0};
+        std::atomic<bool> m_framebufferResized{false};
 
         std::string m_title;
         GLFWwindow *m_window;